@@ -0,0 +1,179 @@
+#include <benchmark/benchmark.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+
+
+using cvip::matrix;
+using cvip::upix_t;
+
+
+// Elementwise kernels of a invert, scale, clamp and threshold chain
+//
+// invert, clamp and threshold are vectorized with  the  OpenCV  universal
+// intrinsics, scale is left to the compiler.
+//
+
+struct invert_kernel
+{
+    void map(upix_t const* src, upix_t* dst, int const count) const
+    {
+        auto i = 0;
+
+#if CV_SIMD
+        auto const all = cv::vx_setall_u8(255);
+
+        for (; i <= count - cv::v_uint8::nlanes; i += cv::v_uint8::nlanes)
+        {
+            cv::v_store(dst + i, all - cv::vx_load(src + i));
+        }
+#endif // CV_SIMD
+
+        for (; i < count; ++i)
+        {
+            dst[i] = static_cast<upix_t>(255 - src[i]);
+        }
+    }
+};
+
+struct scale_kernel
+{
+    void map(upix_t const* src, upix_t* dst, int const count) const
+    {
+        for (auto i = 0; i < count; ++i)
+        {
+            dst[i] = static_cast<upix_t>((3 * src[i]) >> 2);
+        }
+    }
+};
+
+struct clamp_kernel
+{
+    void map(upix_t const* src, upix_t* dst, int const count) const
+    {
+        auto i = 0;
+
+#if CV_SIMD
+        auto const lo = cv::vx_setall_u8(16);
+        auto const hi = cv::vx_setall_u8(235);
+
+        for (; i <= count - cv::v_uint8::nlanes; i += cv::v_uint8::nlanes)
+        {
+            cv::v_store(dst + i, cv::v_min(cv::v_max(cv::vx_load(src + i), lo), hi));
+        }
+#endif // CV_SIMD
+
+        for (; i < count; ++i)
+        {
+            dst[i] = std::min<upix_t>(std::max<upix_t>(src[i], 16), 235);
+        }
+    }
+};
+
+struct threshold_kernel
+{
+    void map(upix_t const* src, upix_t* dst, int const count) const
+    {
+        auto i = 0;
+
+#if CV_SIMD
+        auto const level = cv::vx_setall_u8(100);
+
+        for (; i <= count - cv::v_uint8::nlanes; i += cv::v_uint8::nlanes)
+        {
+            cv::v_store(dst + i, cv::vx_load(src + i) > level);
+        }
+#endif // CV_SIMD
+
+        for (; i < count; ++i)
+        {
+            dst[i] = static_cast<upix_t>(src[i] > 100 ? 255 : 0);
+        }
+    }
+};
+
+
+// Predicates applying a kernel on the whole image; the unfused ones do not
+// expose the kernel, so they are applied one at a time.
+//
+
+template<typename Kernel>
+struct unfused_predicate
+{
+    void do_apply(matrix& dst, matrix& src, bool const first)
+    {
+        dst.create(src.rows, src.cols, src.type());
+
+        for (auto y = 0; y < src.rows; ++y)
+        {
+            m_kernel.map(src.ptr<upix_t>(y), dst.ptr<upix_t>(y), src.cols * src.channels());
+        }
+
+        if (first)
+        {
+            src = matrix{ };
+        }
+    }
+
+    Kernel m_kernel = { };
+};
+
+template<typename Kernel>
+struct fused_predicate : public unfused_predicate<Kernel>
+{
+    void map(upix_t const* src, upix_t* dst, int const count) const
+    {
+        this->m_kernel.map(src, dst, count);
+    }
+};
+
+
+template<template<typename> typename Predicate>
+static auto make_static_chain()
+{
+    return cvip::core::make_static(cvip::core::basic_operator<Predicate<threshold_kernel>>{ },
+                                   cvip::core::basic_operator<Predicate<clamp_kernel>>{ },
+                                   cvip::core::basic_operator<Predicate<scale_kernel>>{ },
+                                   cvip::core::basic_operator<Predicate<invert_kernel>>{ });
+}
+
+template<template<typename> typename Predicate>
+static auto make_dynamic_chain()
+{
+    return cvip::core::basic_operator<Predicate<threshold_kernel>>{ }
+         * cvip::core::basic_operator<Predicate<clamp_kernel>>{ }
+         * cvip::core::basic_operator<Predicate<scale_kernel>>{ }
+         * cvip::core::basic_operator<Predicate<invert_kernel>>{ };
+}
+
+
+// invert, scale, clamp and threshold chain, unfused versus fused
+//
+
+template<typename Expression>
+static void pointwise_chain_apply(benchmark::State& state, Expression ex)
+{
+    auto const side = static_cast<int>(state.range(0));
+
+    auto x = matrix(side, side, CV_8UC1, cv::Scalar::all(77));
+
+    for (auto _ : state)
+    {
+        auto y = ex * x;
+
+        benchmark::DoNotOptimize(y.data);
+    }
+
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * x.total() * x.elemSize());
+}
+
+BENCHMARK_CAPTURE(pointwise_chain_apply, static_unfused, make_static_chain<unfused_predicate>())
+    ->Arg(256)->Arg(4096);
+BENCHMARK_CAPTURE(pointwise_chain_apply, static_fused, make_static_chain<fused_predicate>())
+    ->Arg(256)->Arg(4096);
+BENCHMARK_CAPTURE(pointwise_chain_apply, dynamic_unfused, make_dynamic_chain<unfused_predicate>())
+    ->Arg(256)->Arg(4096);
+BENCHMARK_CAPTURE(pointwise_chain_apply, dynamic_fused, make_dynamic_chain<fused_predicate>())
+    ->Arg(256)->Arg(4096);
@@ -0,0 +1,9 @@
+
+#include <benchmark/benchmark.h>
+
+
+// Benchmarks are registered in their own translation units by means of the
+// BENCHMARK macros, this file only provides the entry point.
+//
+
+BENCHMARK_MAIN();
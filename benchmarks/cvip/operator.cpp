@@ -0,0 +1,215 @@
+#include <benchmark/benchmark.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include <utility>
+
+
+using cvip::matrix;
+
+
+// Predicates used in the benchmarks
+//
+// passthrough_predicate does no pixel work at all, it just hands its input
+// over as its output, so the time measured with it is the pure overhead  of
+// the operator and expression machinery. invert_predicate touches each pixel
+// once, as a typical cheap point operation does.
+//
+
+struct passthrough_predicate
+{
+    void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+    {
+        cvip::swap(dst, src);
+    }
+};
+
+struct invert_predicate
+{
+    void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+    {
+        dst.create(src.rows, src.cols, src.type());
+
+        for (auto y = 0; y < src.rows; ++y)
+        {
+            auto const* in  = src.ptr<cvip::upix_t>(y);
+            auto*       out = dst.ptr<cvip::upix_t>(y);
+
+            for (auto x = 0; x < src.cols * src.channels(); ++x)
+            {
+                out[x] = static_cast<cvip::upix_t>(255 - in[x]);
+            }
+        }
+
+        src = matrix{ };
+    }
+};
+
+using passthrough_operator = cvip::core::basic_operator<passthrough_predicate>;
+using invert_operator      = cvip::core::basic_operator<invert_predicate>;
+
+
+template<typename Operator>
+static cvip::core::operator_expression make_expression(Operator const& op, int const length)
+{
+    auto ex = op * op;
+
+    for (auto k = 2; k < length; ++k)
+    {
+        ex = op * std::move(ex);
+    }
+
+    return ex;
+}
+
+static matrix make_image(int const side)
+{
+    return matrix(side, side, CV_8UC1, cv::Scalar::all(7));
+}
+
+
+// Single operator apply versus operator_expression apply
+//
+
+template<typename Operator>
+static void single_operator_apply(benchmark::State& state)
+{
+    auto op = Operator{ };
+    auto x  = make_image(static_cast<int>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        auto y = op * x;
+
+        benchmark::DoNotOptimize(y.data);
+    }
+}
+
+template<typename Operator>
+static void dynamic_expression_apply(benchmark::State& state)
+{
+    auto ex = make_expression(Operator{ }, 2);
+    auto x  = make_image(static_cast<int>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        auto y = ex * x;
+
+        benchmark::DoNotOptimize(y.data);
+    }
+}
+
+template<typename Operator>
+static void static_expression_apply(benchmark::State& state)
+{
+    auto ex = cvip::core::make_static(Operator{ }, Operator{ });
+    auto x  = make_image(static_cast<int>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        auto y = ex * x;
+
+        benchmark::DoNotOptimize(y.data);
+    }
+}
+
+BENCHMARK_TEMPLATE(single_operator_apply, passthrough_operator)->Arg(64);
+BENCHMARK_TEMPLATE(dynamic_expression_apply, passthrough_operator)->Arg(64);
+BENCHMARK_TEMPLATE(static_expression_apply, passthrough_operator)->Arg(64);
+BENCHMARK_TEMPLATE(single_operator_apply, invert_operator)->Arg(64)->Arg(1024);
+BENCHMARK_TEMPLATE(dynamic_expression_apply, invert_operator)->Arg(64)->Arg(1024);
+BENCHMARK_TEMPLATE(static_expression_apply, invert_operator)->Arg(64)->Arg(1024);
+
+
+// Expression construction cost (clone and chain allocation) versus length
+//
+
+static void expression_construction(benchmark::State& state)
+{
+    auto const op     = passthrough_operator{ };
+    auto const length = static_cast<int>(state.range(0));
+
+    for (auto _ : state)
+    {
+        auto ex = make_expression(op, length);
+
+        benchmark::DoNotOptimize(&ex);
+    }
+
+    state.SetComplexityN(length);
+}
+
+BENCHMARK(expression_construction)->RangeMultiplier(2)->Range(2, 64)->Complexity(benchmark::oN);
+
+
+// Per stage overhead on tiny (64x64) and huge (8k x 8k) images, the time per
+// stage is reported as a rate.
+//
+
+template<typename Operator>
+static void per_stage_apply(benchmark::State& state)
+{
+    auto const length = static_cast<int>(state.range(1));
+
+    auto ex = make_expression(Operator{ }, length);
+    auto x  = make_image(static_cast<int>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        auto y = ex * x;
+
+        benchmark::DoNotOptimize(y.data);
+    }
+
+    state.counters["stages"] = benchmark::Counter(static_cast<double>(state.iterations()) * length,
+                                                  benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * length * x.total() * x.elemSize());
+}
+
+BENCHMARK_TEMPLATE(per_stage_apply, passthrough_operator)->ArgsProduct({ { 64 }, { 2, 4, 8, 16 } });
+BENCHMARK_TEMPLATE(per_stage_apply, invert_operator)->ArgsProduct({ { 64, 8192 }, { 2, 4, 8 } })
+    ->Unit(benchmark::kMillisecond);
+
+
+// Copy versus move of expressions
+//
+
+static void expression_copy(benchmark::State& state)
+{
+    auto const length = static_cast<std::size_t>(state.range(0));
+
+    auto const ex = make_expression(passthrough_operator{ }, static_cast<int>(length));
+
+    for (auto _ : state)
+    {
+        auto copy = ex;
+
+        // REMARK: A copy shares the operators of the original until they
+        //         are retuned, each stage is reached for to measure a full,
+        //         independent copy rather than the reference counts.
+
+        for (auto k = std::size_t{ 0 }; k < length; ++k)
+        {
+            benchmark::DoNotOptimize(&copy.stage<passthrough_operator>(k));
+        }
+
+        benchmark::DoNotOptimize(&copy);
+    }
+}
+
+static void expression_move(benchmark::State& state)
+{
+    auto ex = make_expression(passthrough_operator{ }, static_cast<int>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        auto moved = std::move(ex);
+
+        benchmark::DoNotOptimize(&moved);
+
+        ex = std::move(moved);
+    }
+}
+
+BENCHMARK(expression_copy)->Arg(4)->Arg(32);
+BENCHMARK(expression_move)->Arg(4)->Arg(32);
@@ -0,0 +1,209 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+
+#ifndef CVIP_CORE_ALLOCATOR_HPP
+#define CVIP_CORE_ALLOCATOR_HPP
+
+#pragma once
+
+
+#include "internal/basic_types.hpp"
+#include <cstddef>
+#include <limits>
+#include <memory>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    // Matrix allocators
+    //
+    // The buffers of the intermediate results of a pipeline are allocated
+    // by the default OpenCV allocator, i.e. freshly, on every application.
+    // A matrix_allocator is a cv::MatAllocator giving matrices 64 bytes
+    // aligned storage, from a pool of blocks, so that the buffers of a
+    // steady stream of frames are reused, and, on request, backed by
+    // transparent huge pages, so that multi hundred megabytes frames are
+    // not paged in 4 KiB at a time:
+    //
+    //      auto allocator = std::make_shared<matrix_allocator>(true);
+    //
+    //      ex.attach_allocator(allocator);
+    //
+    // An allocator is used by the expressions it is attached to, for their
+    // intermediate results, their scratch buffers and their results, and by
+    // all the operators, expressions and plans applied in the scope of an
+    // allocator_scope, e.g. by the workers of an async_executor. A scope may
+    // leave the results handed to the caller to the default allocator, e.g.
+    // when the allocator pools memory that should not outlive the batch.
+    //
+    // Blocks are kept for reuse when the matrices using them are released,
+    // up to the capacity of the pool, and given back to the system when the
+    // allocator is cleared or destroyed. The matrices allocated by an
+    // allocator may outlive it, its pool is kept until the last of them is
+    // released.
+    //
+    // All member functions are thread safe.
+    //
+
+    namespace core
+    {
+
+        class matrix_allocator : public cv::MatAllocator
+        {
+        public:
+
+            // Allocator usage statistics
+            //
+            struct statistics
+            {
+                std::size_t allocations = 0;  // matrices allocated
+                std::size_t reuses      = 0;  // allocations served by a pooled block
+                std::size_t blocks      = 0;  // blocks obtained from the system
+                std::size_t bytes       = 0;  // bytes currently in use by matrices
+                std::size_t pooled      = 0;  // bytes currently kept for reuse
+                std::size_t peak        = 0;  // maximum number of bytes ever in use
+            };
+
+            static constexpr std::size_t alignment = 64;
+
+            // Size and alignment of the blocks backed by huge pages, smaller
+            // blocks are not
+            //
+            static constexpr std::size_t huge_page_size = std::size_t{ 2 } * 1024 * 1024;
+
+            static constexpr auto unlimited = std::numeric_limits<std::size_t>::max();
+
+
+        public:
+
+            // The capacity limits the number of bytes kept for reuse
+            //
+            explicit matrix_allocator(bool const huge_pages = false, std::size_t const capacity = unlimited);
+
+            matrix_allocator(matrix_allocator const& src) = delete;
+
+            matrix_allocator(matrix_allocator&& src) = delete;
+
+            virtual ~matrix_allocator() noexcept;
+
+            matrix_allocator& operator=(matrix_allocator const& src) = delete;
+
+            matrix_allocator& operator=(matrix_allocator&& src) = delete;
+
+
+        public:
+
+            // The allocator in scope in the calling thread, see allocator_scope,
+            // null if there is none
+            //
+            static matrix_allocator* current() noexcept;
+
+            // The allocator in scope in the calling thread for the results
+            // handed to the caller, null if there is none or if the scope
+            // leaves them to the default allocator
+            //
+            static matrix_allocator* current_for_results() noexcept;
+
+            // Give the blocks kept for reuse back to the system
+            //
+            void clear();
+
+            // Whether large blocks are backed by huge pages
+            //
+            bool huge_pages() const noexcept;
+
+            // Capacity in bytes
+            //
+            std::size_t capacity() const noexcept;
+
+            // Usage statistics
+            //
+            statistics stats() const;
+
+            // Whether the data of a matrix was allocated by this allocator
+            //
+            bool owns(matrix const& mat) const noexcept;
+
+
+        public:
+
+            // cv::MatAllocator interface, matrices on user data are handed
+            // to the standard allocator
+            //
+
+            virtual cv::UMatData* allocate(int dims, int const* sizes, int type, void* data, std::size_t* step,
+                                           cv::AccessFlag flags, cv::UMatUsageFlags usage) const override;
+
+            virtual bool allocate(cv::UMatData* data, cv::AccessFlag flags, cv::UMatUsageFlags usage) const override;
+
+            virtual void deallocate(cv::UMatData* data) const override;
+
+
+        private:
+
+            // The pool of blocks, shared by the allocator and the matrices
+            // it allocated
+            //
+
+            class pool_t;
+
+
+        private:
+
+            std::shared_ptr<pool_t> m_pool;
+
+        };
+
+
+        // Install an allocator for the calling thread until the scope ends,
+        // see matrix_allocator::current, for the results too unless told
+        // otherwise; scopes nest, and a null allocator stands for the
+        // default one
+        //
+
+        class allocator_scope
+        {
+        public:
+
+            explicit allocator_scope(matrix_allocator* allocator, bool const results = true) noexcept;
+
+            allocator_scope(allocator_scope const& src) = delete;
+
+            allocator_scope(allocator_scope&& src) = delete;
+
+            ~allocator_scope() noexcept;
+
+            allocator_scope& operator=(allocator_scope const& src) = delete;
+
+            allocator_scope& operator=(allocator_scope&& src) = delete;
+
+
+        private:
+
+            matrix_allocator* m_previous = nullptr;
+
+            bool              m_previous_results = true;
+
+        };
+
+    }
+
+}
+
+
+#endif // !CVIP_CORE_ALLOCATOR_HPP
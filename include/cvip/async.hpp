@@ -0,0 +1,204 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+
+#ifndef CVIP_CORE_ASYNC_HPP
+#define CVIP_CORE_ASYNC_HPP
+
+#pragma once
+
+
+#include "allocator.hpp"
+#include "expression.hpp"
+#include "frozen.hpp"
+#include "i_operator.hpp"
+#include "scheduler.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    // Asynchronous application of operators
+    //
+    // Applies an operator, an operator expression or a frozen expression on
+    // a matrix in the background and returns a future of the result, so
+    // that the calling thread can go on, e.g. decoding the next frame:
+    //
+    //      auto y = apply_async(ex, std::move(x));
+    //
+    //      ...
+    //
+    //      use(y.get());
+    //
+    // The work runs on an async_executor, a pool with a fixed number of
+    // worker threads and a bounded number of applications in flight, i.e.
+    // queued or running. Submitting to a full executor blocks until one of
+    // them is done (backpressure), so that a fast producer can not queue an
+    // unbounded number of frames; async_executor::try_submit returns an
+    // invalid future instead.
+    //
+    // An operator or an expression is cloned when submitted, so it may be
+    // modified or destroyed afterwards. A frozen expression is not cloned,
+    // which makes it the cheapest to apply asynchronously. As with
+    // operator*, the matrix may be handed over with std::move.
+    //
+    // An application may be cancelled through a cancel_token: if it was not
+    // started yet, it never runs and its future throws cancelled_error; if
+    // it is running, it completes.
+    //
+    // Blocking submissions must not be made from the work running on the
+    // same executor, since a full executor could never drain.
+    //
+
+    namespace core
+    {
+
+        // Thrown by the future of a cancelled application
+        //
+        class cancelled_error : public std::runtime_error
+        {
+        public:
+
+            cancelled_error() :
+                std::runtime_error("apply_async: cancelled")
+            {
+                // NOOP
+            }
+        };
+
+
+        // Cancellation request, shared by its copies
+        //
+        class cancel_token
+        {
+        public:
+
+            cancel_token();
+
+            void cancel() noexcept;
+
+            bool cancelled() const noexcept;
+
+
+        private:
+
+            std::shared_ptr<std::atomic<bool>> m_flag = { };
+
+        };
+
+
+        class async_executor
+        {
+        public:
+
+            using work_t = std::function<matrix()>;
+
+
+        public:
+
+            // A capacity of zero means four applications in flight per worker,
+            // the work runs in the scope of the given allocator, if any
+            //
+            explicit async_executor(std::size_t const workers = task_scheduler::default_workers(),
+                                    std::size_t const capacity = 0,
+                                    std::shared_ptr<matrix_allocator> allocator = { });
+
+            async_executor(async_executor const& src) = delete;
+
+            async_executor(async_executor&& src) = delete;
+
+            // Waits for the applications in flight to finish
+            //
+            ~async_executor() noexcept = default;
+
+            async_executor& operator=(async_executor const& src) = delete;
+
+            async_executor& operator=(async_executor&& src) = delete;
+
+
+        public:
+
+            // Process wide executor, with a worker per hardware thread
+            //
+            static async_executor& global();
+
+            // Queue some work, waiting while the executor is full
+            //
+            std::future<matrix> submit(work_t work, cancel_token const& token = { });
+
+            // Queue some work, unless the executor is full, in which case the
+            // returned future is not valid
+            //
+            std::future<matrix> try_submit(work_t work, cancel_token const& token = { });
+
+            // Maximum number of applications in flight
+            //
+            std::size_t capacity() const noexcept;
+
+            // Number of applications queued or running
+            //
+            std::size_t in_flight() const;
+
+
+        private:
+
+            std::future<matrix> enqueue(work_t work, cancel_token const& token);
+
+            void release() noexcept;
+
+
+        private:
+
+            std::size_t m_capacity = 0;
+
+            std::size_t m_in_flight = 0;
+
+            mutable std::mutex m_lock = { };
+
+            std::condition_variable m_room = { };  // an application in flight is done
+
+            std::shared_ptr<matrix_allocator> m_allocator = { };
+
+            task_scheduler m_scheduler;  // last, so that it finishes its work first
+
+        };
+
+
+        std::future<matrix> apply_async(i_operator const& op, matrix rhs_im, cancel_token const& token = { },
+                                        async_executor& executor = async_executor::global());
+
+        std::future<matrix> apply_async(operator_expression const& ex, matrix rhs_im,
+                                        cancel_token const& token = { },
+                                        async_executor& executor = async_executor::global());
+
+        std::future<matrix> apply_async(frozen_expression const& ex, matrix rhs_im,
+                                        cancel_token const& token = { },
+                                        async_executor& executor = async_executor::global());
+
+    }
+
+}
+
+
+#endif // !CVIP_CORE_ASYNC_HPP
@@ -0,0 +1,86 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_BATCH_HPP
+#define CVIP_CORE_BATCH_HPP
+
+#pragma once
+
+
+#include "expression.hpp"
+#include "i_operator.hpp"
+#include "numa.hpp"
+#include <vector>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    // Batch application of operators
+    //
+    // Applies an operator, or an operator expression, on each matrix in a
+    // range of input matrices, and stores the results, in the same order,
+    // in the output range.
+    //
+    // With execution_model::parallel the  input  matrices  are distributed
+    // among as many worker threads as the hardware supports. Each worker
+    // applies its own clone of the operator, or of every operator in the
+    // expression,  so  operator  state and processing buffers are never
+    // shared among threads. With execution_model::sequential the matrices
+    // are processed, in order, in the calling thread.
+    //
+    // With a numa_scheduler, the matrices are distributed among its workers,
+    // each one applying its own clone, so that each matrix is processed on
+    // a single node, with its intermediate results on that node, see
+    // numa.hpp.
+    //
+    // The given operator or expression is never modified. If applying the
+    // operator on any matrix throws, the remaining matrices are skipped and
+    // the first exception is rethrown in the calling thread.
+    //
+
+    namespace core
+    {
+
+        std::vector<matrix> batch_apply(i_operator const& op, std::vector<matrix> const& rhs_ims,
+                                        execution_model const model = execution_model::parallel);
+
+        std::vector<matrix> batch_apply(operator_expression const& ex, std::vector<matrix> const& rhs_ims,
+                                        execution_model const model = execution_model::parallel);
+
+        std::vector<matrix> batch_apply(i_operator const& op, std::vector<matrix> const& rhs_ims,
+                                        numa_scheduler& scheduler);
+
+        std::vector<matrix> batch_apply(operator_expression const& ex, std::vector<matrix> const& rhs_ims,
+                                        numa_scheduler& scheduler);
+
+        template<typename InputIt, typename OutputIt>
+        OutputIt batch_apply(i_operator const& op, InputIt first, InputIt last, OutputIt d_first,
+                             execution_model const model = execution_model::parallel);
+
+        template<typename InputIt, typename OutputIt>
+        OutputIt batch_apply(operator_expression const& ex, InputIt first, InputIt last, OutputIt d_first,
+                             execution_model const model = execution_model::parallel);
+
+    }
+
+}
+
+
+#include "internal/batch.inl"
+
+
+#endif // !CVIP_CORE_BATCH_HPP
@@ -0,0 +1,151 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_BUFFER_POOL_HPP
+#define CVIP_CORE_BUFFER_POOL_HPP
+
+#pragma once
+
+
+#include "internal/basic_types.hpp"
+#include <cstddef>
+#include <limits>
+#include <list>
+#include <mutex>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        // Scratch buffer pool
+        //
+        // Keeps the buffers it hands out alive between uses, so that a  steady
+        // stream of same sized images can be processed without any heap
+        // allocation. Buffers are keyed by size and type.
+        //
+        // The pool holds a reference to each buffer it allocated; a buffer is
+        // available again as soon as every other reference to it is  dropped,
+        // i.e. when its reference count shows that only the pool holds it.
+        // Hence, a result handed to the caller is recycled once the  caller
+        // releases it.
+        //
+        // The capacity limits the number of bytes held by the pool. When a
+        // new buffer does not fit, the least recently used available buffers
+        // are dropped; if it still does not fit, the buffer is handed out but
+        // not retained. By default, a pool holds up to 256 MiB, so that an
+        // expression applied on images of ever changing sizes does not grow
+        // it without bound.
+        //
+        // All member functions are thread safe.
+        //
+
+        class buffer_pool
+        {
+        public:
+
+            // Pool usage statistics
+            //
+            struct statistics
+            {
+                std::size_t hits      = 0;  // acquisitions served by an available buffer
+                std::size_t misses    = 0;  // acquisitions that required an allocation
+                std::size_t evictions = 0;  // buffers dropped to honour the capacity
+                std::size_t buffers   = 0;  // buffers currently held
+                std::size_t bytes     = 0;  // bytes currently held
+                std::size_t peak      = 0;  // maximum number of bytes ever held
+            };
+
+            static constexpr auto unlimited        = std::numeric_limits<std::size_t>::max();
+            static constexpr auto default_capacity = std::size_t{ 256 * 1024 * 1024 };
+
+
+        public:
+
+            explicit buffer_pool(std::size_t const capacity = default_capacity);
+
+            buffer_pool(buffer_pool const& src) = delete;
+
+            buffer_pool(buffer_pool&& src) = delete;
+
+            ~buffer_pool() noexcept = default;
+
+            buffer_pool& operator=(buffer_pool const& src) = delete;
+
+            buffer_pool& operator=(buffer_pool&& src) = delete;
+
+
+        public:
+
+            // Get a buffer of the given size and type, its content is undefined
+            //
+            matrix acquire(int const rows, int const cols, int const type);
+
+            // Drop every buffer not in use
+            //
+            void clear();
+
+            // Capacity in bytes
+            //
+            std::size_t capacity() const noexcept;
+
+            // Usage statistics
+            //
+            statistics stats() const;
+
+
+        private:
+
+            struct entry_t
+            {
+                int    rows;
+                int    cols;
+                int    type;
+                matrix buffer;
+            };
+
+            using entries_t = std::list<entry_t>;
+
+
+        private:
+
+            static bool available(matrix const& buffer) noexcept;
+
+            static std::size_t bytes_of(matrix const& buffer) noexcept;
+
+            void evict(std::size_t const required);
+
+
+        private:
+
+            std::size_t const  m_capacity;
+
+            mutable std::mutex m_lock = { };
+
+            entries_t          m_entries = { };  // most recently used first
+
+            statistics         m_stats = { };
+
+        };
+
+    }
+
+}
+
+
+#endif // !CVIP_CORE_BUFFER_POOL_HPP
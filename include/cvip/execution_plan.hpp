@@ -0,0 +1,181 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+
+#ifndef CVIP_CORE_EXECUTION_PLAN_HPP
+#define CVIP_CORE_EXECUTION_PLAN_HPP
+
+#pragma once
+
+
+#include "expression.hpp"
+#include "i_operator.hpp"
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    // Execution plans
+    //
+    // Applying an expression decides, on each call, how to run the chain:
+    // which operators to fuse, into which buffer each stage writes, whether
+    // and how to tile the image. When the same chain is applied on many
+    // images of the same size and type, e.g. the frames of a video, those
+    // decisions can be taken once:
+    //
+    //      auto plan = ex.compile({ 1080, 1920, CV_8UC3 });
+    //
+    //      for (auto const& frame : video)
+    //      {
+    //          auto y = plan * frame;
+    //      }
+    //
+    // A plan is a flat list of steps, each one a single operator or a fused
+    // run of pointwise operators, with the buffer it writes into: its own
+    // source when it may work in place, a scratch buffer owned by the plan
+    // when the shape of its result is known, or a new buffer otherwise.
+    // After an operator whose output shape is unknown, see i_operator::infer,
+    // the remaining operators are grouped when the plan is applied, as the
+    // expression would do.
+    // When the expression has tiling enabled, the plan also holds the tiles
+    // of the image, and a list of steps for each distinct tile shape.
+    //
+    // The plan holds the operators of the expression as they were when it
+    // was compiled; retuning the expression afterwards does not change it.
+    // Plans do not use the result cache, the buffer pool, the allocator or
+    // the incremental mode of the expression, but the allocator in scope, see
+    // allocator_scope. Applying a plan on an image of another size or type
+    // throws std::invalid_argument.
+    //
+    // Copies of a plan share its operators, but not its scratch buffers. As
+    // an expression, a plan must not be applied from several threads at once.
+    //
+
+    namespace core
+    {
+
+        class execution_plan
+        {
+        public:
+
+            execution_plan(execution_plan const& src) = default;
+
+            execution_plan(execution_plan&& src) noexcept = default;
+
+            ~execution_plan() noexcept = default;
+
+            execution_plan& operator=(execution_plan const& src) = default;
+
+            execution_plan& operator=(execution_plan&& src) noexcept = default;
+
+
+        public:
+
+            // Size and type of the images the plan applies on
+            //
+            matrix_shape const& input() const noexcept;
+
+            // Number of steps on the whole image, or on its first tile
+            //
+            std::size_t steps() const noexcept;
+
+            // Number of tiles, one if the image is not tiled
+            //
+            std::size_t tiles() const noexcept;
+
+
+        public:
+
+            friend matrix operator*(execution_plan& lhs_plan, matrix const& rhs_im);
+
+            friend matrix operator*(execution_plan& lhs_plan, matrix&& rhs_im);
+
+            friend class operator_expression;
+
+
+        private:
+
+            using opchain_t = operator_expression::opchain_t;
+
+            using opscratch_t = operator_expression::opscratch_t;
+
+            struct step_t
+            {
+                std::size_t first = 0;  // first operator
+                std::size_t count = 1;  // operators, more than one if fused
+
+                bool resolved = true;   // grouped when the plan was built
+                bool in_place = false;  // may overwrite its source if unshared
+                bool scratch  = false;  // writes into a scratch buffer
+
+                std::optional<matrix_shape> shape = { };  // inferred output shape
+            };
+
+            using program_t = std::vector<step_t>;
+
+            struct tile_t
+            {
+                rect tile = { };             // part of the result
+                rect area = { };             // part of the input, the tile grown by the halo
+                std::size_t program = 0;     // steps for the area
+            };
+
+
+        private:
+
+            execution_plan(opchain_t const& chain, matrix_shape const& input, int const tile_side, int const halo);
+
+            std::size_t build(matrix_shape const& area);
+
+            matrix apply(matrix&& rhs_im);
+
+            // Run a program, the result of its last step is allocated by the
+            // given allocator, null for the default one
+            //
+            void run(program_t const& program, matrix& dst, matrix& src, bool const owned,
+                     matrix_allocator* const results);
+
+            void execute(step_t const& step, matrix& dst, matrix& src, bool& first, bool const owned,
+                         matrix_allocator* const results);
+
+
+        private:
+
+            opchain_t m_chain = { };
+
+            matrix_shape m_input = { };
+
+            std::vector<program_t> m_programs = { };
+
+            std::vector<matrix_shape> m_areas = { };  // input shape of each program
+
+            std::vector<tile_t> m_tiles = { };  // empty if the image is not tiled
+
+            opscratch_t m_scratch = { };
+
+            std::size_t m_bytes = 0;  // size of each scratch buffer
+
+        };
+
+    }
+
+}
+
+
+#endif // !CVIP_CORE_EXECUTION_PLAN_HPP
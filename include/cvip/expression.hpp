@@ -16,9 +16,19 @@
 #pragma once
 
 
+#include "allocator.hpp"
+#include "buffer_pool.hpp"
 #include "i_operator.hpp"
-#include <list>
+#include "internal/chain_storage.hpp"
+#include "result_cache.hpp"
+#include "rewrite.hpp"
+#include <array>
+#include <cstddef>
+#include <future>
 #include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 
 #if not defined(CVIP_CONFIG_LOADED)
 #error ERROR: Missing config.hpp
@@ -142,10 +152,177 @@ namespace cvip
     // Even though, if the operators  are equivalent,  Example 1 and Example 5,
     // produce the same result.
     //
+    // Tiled execution
+    //
+    // By default, each operator in an expression  is applied on the  whole
+    // image before the next one starts,  so the image is streamed  through
+    // memory once per operator.  When  tiling  is enabled on an expression
+    // and every operator in it is local (see operator_traits::halo),  the
+    // whole chain is applied on cache sized tiles of the image, one at the
+    // time.  Each tile is grown by the sum of the halos of the operators,
+    // so that the pixels in the tile are computed from  the  same  inputs
+    // they would have in a whole image evaluation.  If any operator is not
+    // local, the expression falls back to the whole image evaluation.
+    //
+    // Buffer pooling
+    //
+    // A scratch buffer pool, owned by the expression or supplied by the user,
+    // can be attached to an expression. The expression then remembers the
+    // size and type of the buffer each operator produced, and on the next
+    // application, hands each operator after the first a recycled buffer
+    // from the pool as its destination; the first one still gets an empty
+    // destination, see i_operator::apply. In steady state, applying the
+    // expression on same sized images performs no heap allocation but the
+    // result of the first operator, as long as the caller releases the
+    // previous results.
+    //
+    // Allocators
+    //
+    // A matrix allocator, see allocator.hpp, can be attached to an expression.
+    // The expression then hands it to each operator with its destination,
+    // so that the intermediate results, the scratch buffers and the result
+    // are allocated by it, e.g. on aligned, pooled, huge page backed blocks.
+    // Without one, the expression uses the allocator in scope, if any.
+    //
+    // Pointwise fusion
+    //
+    // Consecutive operators that provide an elementwise kernel for the depth
+    // of the image (see operator_traits::pointwise) are fused: instead of
+    // applying them one after the other on the whole image, the kernels are
+    // applied in turn on a cache sized span of each row, so that the image
+    // is read once and the result written once. A chain like  invert, scale,
+    // clamp and threshold takes a single pass and no intermediate buffers.
+    // A fused run is reported to the stage observer as a single  stage  of
+    // its first operator.
+    //
+    // Result caching
+    //
+    // A result cache, owned by the expression or shared among expressions,
+    // can be attached to an expression. When every operator in the chain
+    // has a fingerprint (see operator_traits::fingerprint), applying the
+    // expression again on an input with the same content returns the cached
+    // result, shared and read only, see result_cache.hpp.
+    //
+    // Rewriting
+    //
+    // On request, the chain is rewritten with the rules in rewrite.hpp, e.g.
+    // dropping identity operators or folding consecutive affine intensity
+    // transforms. Rewriting is never implicit, an expression is applied as
+    // it was built until optimize is called:
+    //
+    //      ex.optimize(rules);
+    //
+    // Shape inference
+    //
+    // Operators may declare the size and type of their output as a function
+    // of those of their input (see i_operator::infer). Before applying  the
+    // chain, the expression infers the shape of every stage, as far as the
+    // operators declare it, so that an input an operator does not  support
+    // is rejected before any pixel work. The intermediate results of known
+    // shape, but that of the first stage, which gets an empty destination,
+    // are written into two scratch buffers owned by the expression, sized
+    // for the largest of them, so no later stage reallocates,  e.g. when the
+    // depth changes halfway through the chain. The result is never written
+    // into a scratch buffer.
+    //
+    // Incremental evaluation
+    //
+    // In incremental mode, an expression keeps the result of  each  stage.
+    // When it is applied again on the same input, i.e. on an image of the
+    // same shape and content, only the stages from the first one whose operator was retuned since
+    // the last application (see i_operator::revision) are recomputed:
+    //
+    //      auto ex = P3 * P2 * P1;
+    //
+    //      ex.enable_incremental();
+    //
+    //      auto y1 = ex * x;                       // P1, P2, P3
+    //
+    //      ex.stage<basic_operator<p3>>(2)(0.5);   // retune P3
+    //
+    //      auto y2 = ex * x;                       // P3 only
+    //
+    // Each stage is applied as if it were the first one in  the  chain,  on
+    // its own destination, so that the kept results are never overwritten.
+    // The chain is neither rewritten, fused nor tiled in this mode, so that
+    // stages keep the index they were built with. The results returned are
+    // copies of the kept ones.
+    //
+    // The input is identified by its shape and a 128-bit hash of its content
+    // (see result_cache::content_hash), so a buffer reused for another image,
+    // e.g. by cv::VideoCapture, or modified in place is told apart, at the
+    // cost of a pass over the input per application. Two images with the
+    // same hash are taken as the same one, invalidate_input forces the next
+    // application to recompute every stage.
+    //
+    // Regions of interest
+    //
+    // A chain of local operators can be applied on a region of an image,
+    // e.g. a candidate box around a moving object, without cropping it:
+    //
+    //      ex.apply_region(frame, box, result(box));
+    //
+    // The halos of the operators are added up backward through the chain,
+    // so that the region is grown just enough for the last stage to be
+    // exact in the region, i.e. the result is the region of the result on
+    // the whole image. The chain runs on a header of the grown region in
+    // the image, never on a copy, and the region of its result is written
+    // into the given output.
+    //
+    // Streaming
+    //
+    // An image larger than memory can be stored in a raw file and  mapped,
+    // see mapped_image.hpp. Streaming applies a chain of local operators on
+    // such an image band by band:
+    //
+    //      auto const in  = mapped_image{ "in.raw", shape };
+    //      auto       out = mapped_image{ "out.raw", shape, mapped_image::access::read_write };
+    //
+    //      ex.stream(in, out);
+    //
+    // Each band of rows is grown by the halo of the chain, processed as a
+    // whole, and its rows written into the output; the input rows no longer
+    // needed and the output rows written are dropped from memory. So, the
+    // memory taken is bounded by the size of a grown band times the number
+    // of buffers the chain needs, whatever the size of the image.
+    //
+    // Copies
+    //
+    // The chain is a contiguous array of operators. Copies of an expression
+    // share the operators but not the chain: adding operators to a copy, or
+    // rewriting it, leaves the original as it was. An operator is copied on
+    // write, when it is retuned through stage() while another expression
+    // still holds it, so retuning a copy never retunes the original.
+    //
+    // Ownership transfer
+    //
+    // Applying an operator or an expression on a matrix never modifies it,
+    // so the first operator always writes its result into a new buffer. A
+    // matrix that is no longer needed by the caller can be handed over:
+    //
+    //      auto y = ex * std::move(x);
+    //
+    // If no other matrix shares its data, the input then becomes one of the
+    // processing buffers: in-place capable operators (see
+    // operator_traits::in_place) overwrite it, and otherwise it is handed to
+    // the second operator as its destination. Shared inputs, e.g. a region
+    // of interest of a larger image, are left untouched as usual.
+    //
 
     namespace core
     {
 
+        class execution_plan;
+
+        class mapped_image;
+
+        template<typename Predicate>
+        class basic_operator;
+
+        template<typename ...Predicates>
+        class static_expression;
+
+
         // Operator expression
         //
         // Allows operator semantics for  image matrix  operations.  Operations
@@ -163,6 +340,12 @@ namespace cvip
 
             operator_expression(operator_expression&& src) noexcept = default;
 
+            // Gather the predicates of a static expression, one stage each,
+            // see static_expression.hpp
+            //
+            template<typename ...Predicates>
+            operator_expression(static_expression<Predicates...> const& src);
+
             ~operator_expression() noexcept = default;
 
             operator_expression& operator=(operator_expression const& src) noexcept = default;
@@ -170,6 +353,124 @@ namespace cvip
             operator_expression& operator=(operator_expression&& src) noexcept = default;
 
 
+        public:
+
+            // Default cache budget for a tile and its processing buffers
+            //
+            static constexpr auto default_tile_cache = std::size_t{ 512 * 1024 };
+
+            // Operators an expression holds before its chain is reallocated
+            //
+            static constexpr auto chain_capacity = detail::chain_storage::default_capacity;
+
+            // Enable tiled execution, tile_cache is the number of bytes a tile
+            // and its processing buffer may take
+            //
+            void enable_tiling(std::size_t tile_cache = default_tile_cache) noexcept;
+
+            // Disable tiled execution
+            //
+            void disable_tiling() noexcept;
+
+            // Attach an expression owned buffer pool of the given capacity
+            //
+            void enable_pooling(std::size_t capacity = buffer_pool::default_capacity);
+
+            // Attach a user supplied buffer pool, or detach it if pool is null
+            //
+            void attach_pool(std::shared_ptr<buffer_pool> pool) noexcept;
+
+            // The attached buffer pool, if any
+            //
+            std::shared_ptr<buffer_pool> const& pool() const noexcept;
+
+            // Attach a user supplied matrix allocator, or detach it if
+            // allocator is null
+            //
+            void attach_allocator(std::shared_ptr<matrix_allocator> allocator) noexcept;
+
+            // The attached matrix allocator, if any
+            //
+            std::shared_ptr<matrix_allocator> const& allocator() const noexcept;
+
+            // Attach an expression owned result cache of the given capacity
+            //
+            void enable_caching(std::size_t capacity = result_cache::default_capacity);
+
+            // Attach a user supplied result cache, or detach it if cache is null
+            //
+            void attach_cache(std::shared_ptr<result_cache> cache) noexcept;
+
+            // The attached result cache, if any
+            //
+            std::shared_ptr<result_cache> const& cache() const noexcept;
+
+            // Keep the result of each stage, and recompute only from the first
+            // stage whose operator changed
+            //
+            void enable_incremental() noexcept;
+
+            // Drop the kept results and recompute every stage
+            //
+            void disable_incremental() noexcept;
+
+            // Recompute every stage on the next application, even on an input
+            // of the same content
+            //
+            void invalidate_input() noexcept;
+
+            // The operator applied at the given stage, e.g. for retuning it;
+            // throws std::out_of_range, or std::bad_cast if it is not an
+            // Operator. Copies of an expression share their operators until
+            // then, so the chain is copied first if it is shared.
+            //
+            template<typename Operator>
+            Operator& stage(std::size_t const index);
+
+            // Shape of the result on an input of the given shape, empty if an
+            // operator does not declare it; throws if an operator does not
+            // support its input
+            //
+            std::optional<matrix_shape> infer(matrix_shape const& input) const;
+
+            // Rewrite the chain with the given rules, see rewrite.hpp; operators
+            // added afterwards are not rewritten until it is called again.
+            // Throws std::runtime_error if the chain is still rewritten after
+            // 64 passes, e.g. by a rule and its inverse; the chain is left as
+            // rewritten so far
+            //
+            void optimize(rewrite_rules const& rules = rewrite_rules::global());
+
+            // Take the decisions of apply once for images of the given size
+            // and type, see execution_plan.hpp; throws if an operator does
+            // not support such an input
+            //
+            execution_plan compile(matrix_shape const& input);
+
+            // Apply the expression on a region of an image, and write the
+            // result into output, e.g. the same region of a larger result;
+            // an empty output gets the result; every operator must be local,
+            // see operator_traits::halo
+            //
+            void apply_region(matrix const& rhs_im, rect const& region, matrix& output);
+
+            // As above, into a temporary header on the caller's result, e.g.
+            // result(box); an empty one would lose the result
+            //
+            void apply_region(matrix const& rhs_im, rect const& region, matrix&& output);
+
+            // Default number of bytes of a band of input rows in streaming
+            //
+            static constexpr auto default_band_size = std::size_t{ 16 * 1024 * 1024 };
+
+            // Apply the expression on a mapped image, band by band, and write
+            // the result into a mapped image of the same size; every operator
+            // must be local, see operator_traits::halo
+            //
+            void stream(mapped_image const& input, mapped_image& output,
+                        std::size_t const band_size = default_band_size);
+
+
         private:
 
             operator_expression(i_operator const& lhs_op, i_operator const& rhs_op);
@@ -177,8 +478,34 @@ namespace cvip
 
         private:
 
+            operator_expression clone() const;
+
             matrix apply(matrix const& rhs_im);
 
+            matrix apply(matrix&& rhs_im);
+
+            matrix compute(matrix&& rhs_im);
+
+            matrix apply_incremental(matrix const& rhs_im);
+
+            i_operator& stage_at(std::size_t const index);
+
+            matrix apply_tiled(matrix const& rhs_im, int const halo);
+
+            void apply_chain(matrix& dst, matrix& src, bool const owned = false);
+
+            void recycle(matrix& dst, std::size_t const stage);
+
+            void plan(matrix_shape const& input);
+
+            int tile_side(matrix_shape const& input, int const halo) const;
+
+            int chain_halo() const;
+
+            std::optional<std::size_t> chain_fingerprint() const;
+
+            bool rewrite_pass(rewrite_rules const& rules);
+
             void emplace_back(operator_expression&& lhs_ex);
 
             void push_back(i_operator const& lhs_op);
@@ -198,22 +525,119 @@ namespace cvip
 
             friend matrix operator*(operator_expression& lhs_ex, matrix const& rhs_im);
 
+            friend matrix operator*(operator_expression& lhs_ex, matrix&& rhs_im);
+
+            friend std::vector<matrix> batch_apply(operator_expression const& ex, std::vector<matrix> const& rhs_ims,
+                                                   execution_model const model);
+
+            friend std::vector<matrix> batch_apply(operator_expression const& ex, std::vector<matrix> const& rhs_ims,
+                                                   numa_scheduler& scheduler);
+
+            friend std::future<matrix> apply_async(operator_expression const& ex, matrix rhs_im,
+                                                   cancel_token const& token, async_executor& executor);
+
+            friend class execution_plan;
+
+            friend class frozen_expression;
+
+            friend class operator_graph;
+
 
         private:
 
-            using opnode_t  = i_operator::opnode_t;
-            using opchain_t = std::list<opnode_t>;
-            using exdata_t  = std::shared_ptr<opchain_t>;
+            using opchain_t = detail::chain_storage;
+
+            using opshape_t = matrix_shape;
+
+            using opshapes_t = std::vector<opshape_t>;
+
+            using opplan_t = std::vector<std::optional<opshape_t>>;
+
+            // Scratch buffers for intermediate results, copies of an
+            // expression do not share them
+            //
+            struct opscratch_t
+            {
+                opscratch_t() noexcept = default;
+
+                opscratch_t(opscratch_t const& src [[maybe_unused]]) noexcept
+                {
+                    // NOOP
+                }
+
+                opscratch_t& operator=(opscratch_t const& src [[maybe_unused]]) noexcept
+                {
+                    return *this;
+                }
+
+                // Make room for the given number of bytes in each buffer, with
+                // the given allocator, or the default one if null
+                //
+                void reserve(std::size_t const bytes, matrix_allocator* const allocator);
+
+                // Header of the given shape on the buffer src is not in
+                //
+                matrix header(matrix_shape const& shape, matrix const& src) const;
+
+                // The data of mat is in one of the buffers
+                //
+                bool holds(matrix const& mat) const noexcept;
+
+                std::array<matrix, 2> buffers = { };
+            };
+
+            struct opstage_t
+            {
+                i_operator const* op = nullptr;  // operator applied
+                std::size_t revision = 0;        // its revision when applied
+                matrix result = { };             // its output
+            };
+
+            struct opstages_t
+            {
+                bool enabled = false;
+                std::optional<result_cache::key_t> input = { };  // shape and content hash of the input
+                std::vector<opstage_t> stages = { };
+            };
 
 
         private:
 
-            exdata_t construct_data(i_operator const& lhs_op, i_operator const& rhs_op);
+            template<typename ...Predicates, std::size_t ...I>
+            static opchain_t construct_data(static_expression<Predicates...> const& src, std::index_sequence<I...>);
+
+            opchain_t construct_data(i_operator const& lhs_op, i_operator const& rhs_op);
+
+            opchain_t::iterator pointwise_end(opchain_t::iterator op, int const depth) const noexcept;
+
+            // The allocator of the intermediate results, or of the result
+            // handed to the caller
+            //
+            matrix_allocator* stage_allocator(bool const result = false) const noexcept;
+
+            static void apply_fused(matrix& dst, matrix& src, opchain_t::const_iterator op,
+                                    opchain_t::const_iterator end, bool const first);
 
 
         private:
 
-            exdata_t m_data = { };
+            opchain_t m_data = { };  // operators, shared with copies until written
+
+            std::size_t m_tile_cache = 0;
+
+            std::shared_ptr<buffer_pool> m_pool = { };
+
+            std::shared_ptr<matrix_allocator> m_allocator = { };
+
+            std::shared_ptr<result_cache> m_cache = { };
+
+            opshapes_t m_shapes = { };  // output shape of each operator in the last application
+
+            opplan_t m_plan = { };        // inferred output shape of each operator
+
+            opscratch_t m_scratch = { };  // buffers for the planned intermediate results
+
+            opstages_t m_stages = { };  // results kept by the incremental mode
 
         };
 
@@ -0,0 +1,140 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+
+#ifndef CVIP_CORE_FROZEN_HPP
+#define CVIP_CORE_FROZEN_HPP
+
+#pragma once
+
+
+#include "expression.hpp"
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    // Frozen expressions
+    //
+    // An operator expression keeps per application state, e.g. its scratch
+    // buffers and inferred shapes, next to its operators, so it must not be
+    // applied from several threads at once. A frozen expression is an
+    // immutable snapshot of an expression that many threads can apply at
+    // once:
+    //
+    //      auto const fx = frozen_expression{ P3 * P2 * P1 };
+    //
+    //      auto y = fx * x;                    // from any thread
+    //
+    // The chain is copied as it is, rewritten or not, when the expression is
+    // frozen, and it never changes afterwards. Each concurrent application
+    // runs on an execution context of its own, holding the per application
+    // state; contexts are reused by later applications, so there are at most
+    // as many contexts as applications ever ran at once. The contexts share
+    // the operators, so applying a frozen expression allocates no chain and
+    // clones no operator.
+    //
+    // REMARK: The operators are applied concurrently, so their predicates
+    //         must not modify themselves in do_apply. Expressions holding
+    //         predicates that do must be cloned per thread instead, as in
+    //         batch_apply.
+    //
+    // Copies of a frozen expression share its operators and its contexts.
+    // All member functions are thread safe.
+    //
+
+    namespace core
+    {
+
+        class frozen_expression
+        {
+        public:
+
+            explicit frozen_expression(operator_expression const& ex);
+
+            frozen_expression(frozen_expression const& src) = default;
+
+            frozen_expression(frozen_expression&& src) noexcept = default;
+
+            ~frozen_expression() noexcept = default;
+
+            frozen_expression& operator=(frozen_expression const& src) = default;
+
+            frozen_expression& operator=(frozen_expression&& src) noexcept = default;
+
+
+        public:
+
+            // Number of execution contexts created so far
+            //
+            std::size_t contexts() const;
+
+
+        public:
+
+            friend matrix operator*(frozen_expression const& lhs_ex, matrix const& rhs_im);
+
+            friend matrix operator*(frozen_expression const& lhs_ex, matrix&& rhs_im);
+
+
+        private:
+
+            using context_t = std::unique_ptr<operator_expression>;
+
+            struct state_t
+            {
+                explicit state_t(operator_expression&& ex) :
+                    chain{ std::move(ex) }
+                {
+                    // NOOP
+                }
+
+                operator_expression const chain;     // configuration, never applied
+
+                std::mutex lock = { };
+
+                std::vector<context_t> idle = { };  // contexts not in use
+
+                std::size_t count = 0;  // contexts created
+            };
+
+
+        private:
+
+            matrix apply(matrix&& rhs_im) const;
+
+            context_t acquire() const;
+
+            void release(context_t context) const noexcept;
+
+
+        private:
+
+            std::shared_ptr<state_t> m_state = { };
+
+        };
+
+    }
+
+}
+
+
+#endif // !CVIP_CORE_FROZEN_HPP
@@ -0,0 +1,162 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_GRAPH_HPP
+#define CVIP_CORE_GRAPH_HPP
+
+#pragma once
+
+
+#include "expression.hpp"
+#include "i_operator.hpp"
+#include "scheduler.hpp"
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    // Operator graphs
+    //
+    // An operator expression is a linear chain: each operator consumes the
+    // result of the previous one. An operator graph is a directed acyclic
+    // graph of operators, where the result of a node may feed several nodes
+    // (fan-out) and a node may combine the results of several nodes (fan-in):
+    //
+    //      auto g = operator_graph{ };
+    //
+    //      auto const pre   = g.add(P1, g.input);
+    //      auto const edges = g.add(P2, pre);
+    //      auto const blobs = g.add(P3, pre);
+    //      auto const mask  = g.combine(both, { edges, blobs });
+    //
+    //      auto const results = g.apply(M1, { mask, edges });  // mask, edges
+    //
+    //      auto const m = g.apply(M1, mask);
+    //
+    // Nodes are added after their sources, so, the graph is acyclic by
+    // construction. Applying a graph computes each node needed for the
+    // requested outputs exactly once, so a shared intermediate result, like
+    // pre above, is computed once for all its consumers.
+    //
+    // With execution_model::parallel, independent nodes run concurrently on
+    // a work-stealing task scheduler; with execution_model::sequential, the
+    // nodes run in order in the calling thread. Either way, an intermediate
+    // result is released as soon as its last consumer is done with it, and
+    // it is handed over, see operator*(i_operator&, matrix&&), to its last
+    // consumer, so that it can be overwritten in place.
+    //
+    // Copies of a graph share its operators, and a graph, as an expression,
+    // must not be applied concurrently from several threads. If a node throws,
+    // the nodes that depend on it are skipped, and the first exception is
+    // rethrown in the calling thread.
+    //
+
+    namespace core
+    {
+
+        class operator_graph
+        {
+        public:
+
+            using node_t = std::size_t;
+
+            // Fan-in node function, it gets the results of its sources in the
+            // order they were given
+            //
+            using combiner_t = std::function<matrix(std::vector<matrix> const& inputs)>;
+
+            // The input image node
+            //
+            static constexpr node_t input = 0;
+
+
+        public:
+
+            operator_graph();
+
+            operator_graph(operator_graph const& src) = default;
+
+            operator_graph(operator_graph&& src) noexcept = default;
+
+            ~operator_graph() noexcept = default;
+
+            operator_graph& operator=(operator_graph const& src) = default;
+
+            operator_graph& operator=(operator_graph&& src) noexcept = default;
+
+
+        public:
+
+            // Add a node applying a clone of the operator, or expression, on
+            // the result of source
+            //
+            node_t add(i_operator const& op, node_t const source);
+
+            node_t add(operator_expression const& ex, node_t const source);
+
+            // Add a node combining the results of the sources
+            //
+            node_t combine(combiner_t combiner, std::vector<node_t> const& sources);
+
+            // Number of nodes, the input included
+            //
+            std::size_t size() const noexcept;
+
+            // Apply the graph on an image and return the results of the given
+            // nodes, in the same order
+            //
+            std::vector<matrix> apply(matrix const& rhs_im, std::vector<node_t> const& outputs,
+                                      execution_model const model = execution_model::parallel,
+                                      task_scheduler& scheduler = task_scheduler::global());
+
+            matrix apply(matrix const& rhs_im, node_t const output,
+                         execution_model const model = execution_model::parallel,
+                         task_scheduler& scheduler = task_scheduler::global());
+
+
+        private:
+
+            // Node function, it may take over the matrices it is given
+            //
+            using function_t = std::function<matrix(std::vector<matrix>& inputs)>;
+
+            struct node_data_t
+            {
+                std::vector<node_t> sources = { };
+                function_t          function = { };
+            };
+
+
+        private:
+
+            node_t add_node(std::vector<node_t> const& sources, function_t function);
+
+
+        private:
+
+            std::vector<node_data_t> m_nodes = { };
+
+        };
+
+    }
+
+}
+
+
+#endif // !CVIP_CORE_GRAPH_HPP
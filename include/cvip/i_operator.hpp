@@ -17,25 +17,91 @@
 
 
 #include "internal/basic_types.hpp"
+#include "internal/predicate_traits.hpp"
+#include <cstddef>
+#include <future>
 #include <memory>
+#include <optional>
 #include <type_traits>
+#include <vector>
 
 #if not defined(CVIP_CONFIG_LOADED)
 #error ERROR: Missing config.hpp
 #endif // defined(CVIP_CONFIG_LOADED)
 
 
+CVIP_BEGIN_IMPLEMENTATION_DETAILS(cvip::core)
+
+    class chain_storage;
+
+CVIP_END_IMPLEMENTATION_DETAILS(cvip::core)
+
+
 namespace cvip
 {
 
     namespace core
     {
 
+        // Operator traits
+        //
+        // Capabilities an operator declares to the expression executors. The
+        // default values describe an operator the executors know nothing about.
+        //
+
+        struct operator_traits
+        {
+            // Neighbourhood radius of a local operator, i.e. each output pixel
+            // depends only on the input pixels within this distance, and the
+            // output has the same size as the input. Negative if the operator
+            // is not local.
+            //
+            int halo = -1;
+
+            // Matrix depths, as a mask of (1 << depth) bits, for which the
+            // operator provides an elementwise kernel, see i_operator::map.
+            // Such an operator maps each input element to the output element
+            // at the same position, and its output has the size and type of
+            // its input. Zero if the operator is not pointwise.
+            //
+            unsigned pointwise = 0u;
+
+            // The operator leaves its input unchanged, e.g. a scaling by one,
+            // so it may be dropped from an expression, see rewrite.hpp.
+            //
+            bool identity = false;
+
+            // Hash of the operator type and parameters, operators with the
+            // same fingerprint produce the same result on the same input, see
+            // result_cache.hpp. Empty if the operator state is unknown.
+            //
+            std::optional<std::size_t> fingerprint = { };
+
+            // The operator may be applied with dst referring to the same data
+            // as src, so the executors run it in place whenever src is  not
+            // shared with anyone else, e.g. the caller's image.
+            //
+            bool in_place = false;
+        };
+
+
+        class async_executor;
+
+        class cancel_token;
+
+        class numa_scheduler;
+
+
         // Interface for image operator classes
         //
 
         class i_operator
         {
+        public:
+
+            virtual ~i_operator() noexcept = default;
+
+
         protected:
 
             // operator chain node type
@@ -56,6 +122,9 @@ namespace cvip
             //       in the chain of operators in an expression; for remaing calls,
             //       a reference  to the buffer  returned by  the first operator in
             //       rhs. On output, the result of a successful operation.
+            //       When the expression has a buffer pool attached, it may hold,
+            //       for the remaining calls, a recycled buffer of the size  and
+            //       type the operator produced in a previous application.
             //
             virtual void apply(matrix& dst, matrix& src, bool const first) = 0;
 
@@ -63,10 +132,63 @@ namespace cvip
             //
             virtual opnode_t clone() const = 0;
 
+            // size of this operator, for copying it with clone_into  into
+            // storage aligned as std::max_align_t; zero if it can only be
+            // copied with clone
+            //
+            virtual std::size_t footprint() const noexcept;
+
+            // copy this operator into storage of footprint() bytes
+            //
+            virtual i_operator* clone_into(void* storage) const;
+
+            // capabilities of this operator
+            //
+            virtual operator_traits traits() const;
+
+            // shape of the output of the operator on an input of the given
+            // shape, empty if it is unknown until the operator is applied;
+            // throws if the operator does not support such an input
+            //
+            virtual std::optional<matrix_shape> infer(matrix_shape const& input) const;
+
+            // number of times the operator parameters were changed, e.g. by
+            // basic_operator::operator(), zero if they never change
+            //
+            virtual std::size_t revision() const noexcept;
+
+            // apply the elementwise kernel of a pointwise operator on a span
+            //
+            // src   : Pointer to count elements of the given depth.
+            //
+            // dst   : Pointer to count elements of the given depth, it may be
+            //         the same as src.
+            //
+            // depth : Matrix depth, one of those in operator_traits::pointwise.
+            //
+            virtual void map(void const* src, void* dst, int const count, int const depth) const;
+
             friend matrix operator*(i_operator& lhs_op, matrix const& rhs_im);
 
+            friend matrix operator*(i_operator& lhs_op, matrix&& rhs_im);
+
+            friend std::vector<matrix> batch_apply(i_operator const& op, std::vector<matrix> const& rhs_ims,
+                                                   execution_model const model);
+
+            friend std::vector<matrix> batch_apply(i_operator const& op, std::vector<matrix> const& rhs_ims,
+                                                   numa_scheduler& scheduler);
+
+            friend std::future<matrix> apply_async(i_operator const& op, matrix rhs_im, cancel_token const& token,
+                                                   async_executor& executor);
+
+            friend class detail::chain_storage;
+
+            friend class execution_plan;
+
             friend class operator_expression;
 
+            friend class operator_graph;
+
         };
 
 
@@ -97,6 +219,69 @@ namespace cvip
             template<typename ...Args>
             void reset(Args&& ...arg);
 
+            // Optional capabilities, detected at compile time by basic_operator
+            //
+            // halo() : Neighbourhood radius of a local operation, see
+            //          operator_traits::halo.
+            //
+            // row_halo() : Rows above and below each output row the operation
+            //              reads, declaring it makes the operation row
+            //              separable: basic_operator may then apply it
+            //              concurrently on horizontal stripes of the image,
+            //              as on the caller's image, so do_apply must not
+            //              modify the predicate. The output must have the
+            //              size of the input.
+            //
+            // output_shape() : Shape of the output on an input of the given
+            //                  shape, see i_operator::infer; it may throw
+            //                  if the input is not supported. It is not
+            //                  required for pointwise predicates.
+            //
+            // identity() : Whether the operation, with its current parameters,
+            //              leaves its input unchanged, see
+            //              operator_traits::identity.
+            //
+            // fingerprint() : Hash of the parameters of the operation, it is
+            //                 not required for predicates with no state, see
+            //                 operator_traits::fingerprint.
+            //
+            // in_place() : Whether the operation may be applied with dst
+            //              referring to the same data as src, see
+            //              operator_traits::in_place.
+            //
+            // map()  : Elementwise kernel for the element type T, i.e. one of
+            //          upix_t, schar, wpix_t, short, int, float or double; it
+            //          may be overloaded or a template. It must allow src and
+            //          dst to be the same span. A predicate with a kernel is
+            //          pointwise, see operator_traits::pointwise.
+            //
+            // do_apply_as<T>() : Typed kernel of the operation, for images
+            //                    whose elements are of type T, as above; it
+            //                    replaces do_apply, so that the operation is
+            //                    written once for all the types it may be
+            //                    constrained to, with no switch on the depth
+            //                    of the image. The kernel for the depth of the
+            //                    input is picked from a table built at compile
+            //                    time, once per application of the operator,
+            //                    see also typed_operator.
+            //
+            //int halo() const;
+            //
+            //int row_halo() const;
+            //
+            //matrix_shape output_shape(matrix_shape const& input) const;
+            //
+            //bool identity() const;
+            //
+            //std::size_t fingerprint() const;
+            //
+            //bool in_place() const;
+            //
+            //void map(T const* src, T* dst, int const count) const;
+            //
+            //template<typename T>
+            //void do_apply_as(matrix& dst, matrix& src, bool const first);
+
         };
 
 
@@ -118,10 +303,11 @@ namespace cvip
             static auto constexpr yes           = sizeof(has_member);
             static auto constexpr has_do_apply  = sizeof(has_do_apply_member<P>(nullptr));
             static auto constexpr is_predicate  = std::is_base_of<i_operator_predicate, P>::value;
+            static auto constexpr is_typed      = detail::typed_depths<P> != 0u;
 
         public:
 
-            static auto constexpr value = is_predicate or has_do_apply == yes;
+            static auto constexpr value = is_predicate or is_typed or has_do_apply == yes;
 
         };
 
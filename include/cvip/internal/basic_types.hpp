@@ -44,6 +44,18 @@ namespace cvip
     using matrix  = cv::Mat;
 
     using point   = cv::Point2i;
+    using rect    = cv::Rect2i;
+
+
+    // Size and type of a matrix
+    //
+
+    struct matrix_shape
+    {
+        int rows = 0;
+        int cols = 0;
+        int type = 0;
+    };
 
 
     // Algoritms/Scanning execution model
@@ -0,0 +1,63 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_BATCH_INL
+#define CVIP_CORE_BATCH_INL
+
+#pragma once
+
+
+#include "../batch.hpp"
+#include <algorithm>
+#include <vector>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        // batch_apply (range)
+        //
+        // REMARK: Copying the matrices into a vector only copies their
+        //         headers, the image data is not duplicated.
+        //
+
+        template<typename InputIt, typename OutputIt>
+        inline OutputIt batch_apply(i_operator const& op, InputIt first, InputIt last, OutputIt d_first,
+                                    execution_model const model)
+        {
+            auto result = batch_apply(op, std::vector<matrix>(first, last), model);
+
+            return std::move(result.begin(), result.end(), d_first);
+        }
+
+        template<typename InputIt, typename OutputIt>
+        inline OutputIt batch_apply(operator_expression const& ex, InputIt first, InputIt last, OutputIt d_first,
+                                    execution_model const model)
+        {
+            auto result = batch_apply(ex, std::vector<matrix>(first, last), model);
+
+            return std::move(result.begin(), result.end(), d_first);
+        }
+
+    }
+
+}
+
+
+#endif // !CVIP_CORE_BATCH_INL
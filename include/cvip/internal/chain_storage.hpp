@@ -0,0 +1,139 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_CHAIN_STORAGE_HPP
+#define CVIP_CORE_CHAIN_STORAGE_HPP
+
+#pragma once
+
+
+#include "../i_operator.hpp"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+CVIP_BEGIN_IMPLEMENTATION_DETAILS(cvip::core)
+
+    // Storage of the operators of an expression
+    //
+    // The operators, in application order, and the table of pointers to them
+    // are kept in a single block, so that building a short chain allocates
+    // once and its stages are iterated over contiguous memory. Operators that
+    // cannot be placed in the block, see i_operator::footprint, are cloned on
+    // the heap instead.
+    //
+    // Copies share the block until one of them is written, i.e. extended or
+    // handed out for retuning, then it gets a block of its own with copies of
+    // the operators. Pointers to the operators are invalidated by any write.
+    //
+
+    class chain_storage
+    {
+    public:
+
+        using iterator       = i_operator* const*;
+        using const_iterator = i_operator* const*;
+
+        // Operators and bytes of operator storage a new block has room for
+        //
+        static constexpr auto default_capacity = std::size_t{ 8 };
+        static constexpr auto default_room     = std::size_t{ 64 } * default_capacity;
+
+
+    public:
+
+        chain_storage() noexcept = default;
+
+        chain_storage(chain_storage const& src) noexcept;
+
+        chain_storage(chain_storage&& src) noexcept;
+
+        ~chain_storage() noexcept;
+
+        chain_storage& operator=(chain_storage const& src) noexcept;
+
+        chain_storage& operator=(chain_storage&& src) noexcept;
+
+        std::size_t size() const noexcept;
+
+        bool empty() const noexcept;
+
+        iterator begin() const noexcept;
+
+        iterator end() const noexcept;
+
+        i_operator* operator[](std::size_t const index) const noexcept;
+
+        // Copy op into the chain, before the operator at the given position
+        //
+        void insert(std::size_t const position, i_operator const& op);
+
+        void push_back(i_operator const& op);
+
+        // The operator at the given position, after making the block private
+        //
+        i_operator& writable(std::size_t const index);
+
+        // Make the block private, copying the operators if it is shared;
+        // true if it was copied
+        //
+        bool detach();
+
+        void clear() noexcept;
+
+
+    private:
+
+        struct block_t
+        {
+            std::atomic<std::size_t>          references = { 1 };
+            std::size_t                       size = 0;      // operators in the block
+            std::size_t                       capacity = 0;  // operators it has room for
+            std::size_t                       used = 0;      // bytes of operator storage used
+            std::size_t                       room = 0;      // bytes of operator storage
+            std::vector<i_operator::opnode_t> spilled = { }; // operators cloned on the heap
+
+            i_operator** table() noexcept;
+
+            unsigned char* storage() noexcept;
+        };
+
+        static block_t* allocate(std::size_t const capacity, std::size_t const room);
+
+        static void release(block_t* block) noexcept;
+
+        // Copy op into the block, which must have room for its pointer
+        //
+        static i_operator* place(block_t& block, i_operator const& op);
+
+        // Make the block private and able to take an operator like op
+        //
+        void reserve(i_operator const& op);
+
+        void copy_into(std::size_t const capacity, std::size_t const room);
+
+
+    private:
+
+        block_t* m_block = nullptr;
+
+    };
+
+CVIP_END_IMPLEMENTATION_DETAILS(cvip::core)
+
+
+#endif // !CVIP_CORE_CHAIN_STORAGE_HPP
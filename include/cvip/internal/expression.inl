@@ -17,6 +17,12 @@
 
 
 #include "../expression.hpp"
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
 #include <utility>
 
 #if not defined(CVIP_CONFIG_LOADED)
@@ -33,19 +39,133 @@ namespace cvip
         // operator_expression
         //
 
+        template<typename ...Predicates>
+        inline operator_expression::operator_expression(static_expression<Predicates...> const& src) :
+            m_data{ construct_data(src, std::index_sequence_for<Predicates...>{ }) }
+        {
+            // NOOP
+        }
+
+        template<typename ...Predicates, std::size_t ...I>
+        inline operator_expression::opchain_t operator_expression::construct_data(
+            static_expression<Predicates...> const& src, std::index_sequence<I...>)
+        {
+            auto data = opchain_t{ };
+
+            auto const stage = [&data](auto const& pr, execution_model const model)
+            {
+                using predicate_t = std::decay_t<decltype(pr)>;
+
+                data.push_back(basic_operator<predicate_t>{ pr }.execution(model));
+            };
+
+            (stage(std::get<I>(src.m_chain), std::get<I>(src.m_models)), ...);
+
+            return data;
+        }
+
+        inline void operator_expression::enable_tiling(std::size_t tile_cache) noexcept
+        {
+            m_tile_cache = tile_cache;
+        }
+
+        inline void operator_expression::disable_tiling() noexcept
+        {
+            m_tile_cache = 0;
+        }
+
+        inline void operator_expression::enable_pooling(std::size_t capacity)
+        {
+            m_pool = std::make_shared<buffer_pool>(capacity);
+        }
+
+        inline void operator_expression::attach_pool(std::shared_ptr<buffer_pool> pool) noexcept
+        {
+            m_pool = std::move(pool);
+        }
+
+        inline std::shared_ptr<buffer_pool> const& operator_expression::pool() const noexcept
+        {
+            return m_pool;
+        }
+
+        inline void operator_expression::attach_allocator(std::shared_ptr<matrix_allocator> allocator) noexcept
+        {
+            m_allocator = std::move(allocator);
+        }
+
+        inline std::shared_ptr<matrix_allocator> const& operator_expression::allocator() const noexcept
+        {
+            return m_allocator;
+        }
+
+        inline void operator_expression::enable_caching(std::size_t capacity)
+        {
+            m_cache = std::make_shared<result_cache>(capacity);
+        }
+
+        inline void operator_expression::attach_cache(std::shared_ptr<result_cache> cache) noexcept
+        {
+            m_cache = std::move(cache);
+        }
+
+        inline std::shared_ptr<result_cache> const& operator_expression::cache() const noexcept
+        {
+            return m_cache;
+        }
+
+        inline void operator_expression::enable_incremental() noexcept
+        {
+            m_stages.enabled = true;
+        }
+
+        inline void operator_expression::disable_incremental() noexcept
+        {
+            m_stages = { };
+        }
+
+        inline void operator_expression::invalidate_input() noexcept
+        {
+            m_stages.input.reset();
+        }
+
+        inline void operator_expression::apply_region(matrix const& rhs_im, rect const& region, matrix&& output)
+        {
+            apply_region(rhs_im, region, output);
+        }
+
+        template<typename Operator>
+        inline Operator& operator_expression::stage(std::size_t const index)
+        {
+            static_assert(is_operator<Operator>::value, "Operator is not an i_operator");
+
+            return dynamic_cast<Operator&>(stage_at(index));
+        }
+
         inline void operator_expression::emplace_back(operator_expression&& lhs_ex)
         {
-            m_data->splice(m_data->end(), std::move(*lhs_ex.m_data));
+            for (auto const* op : lhs_ex.m_data)
+            {
+                m_data.push_back(*op);
+            }
+
+            lhs_ex.m_data.clear();
+
+            m_stages.stages.clear();
         }
 
         inline void operator_expression::push_back(i_operator const& lhs_op)
         {
-            m_data->emplace_back(lhs_op.clone());
+            m_data.push_back(lhs_op);
+
+            m_stages.stages.clear();
         }
 
         inline void operator_expression::push_front(i_operator const& rhs_op)
         {
-            m_data->emplace_front(rhs_op.clone());
+            m_data.insert(0, rhs_op);
+
+            m_stages.stages.clear();
         }
 
 
@@ -115,6 +235,16 @@ namespace cvip
             return lhs_ex * rhs_im;
         }
 
+        inline matrix operator*(operator_expression& lhs_ex, matrix&& rhs_im)
+        {
+            return lhs_ex.apply(std::move(rhs_im));
+        }
+
+        inline matrix operator*(operator_expression&& lhs_ex, matrix&& rhs_im)
+        {
+            return lhs_ex * std::move(rhs_im);
+        }
+
     }
 
 }
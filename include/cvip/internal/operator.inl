@@ -17,7 +17,10 @@
 
 
 #include "../operator.hpp"
+#include <cstddef>
 #include <memory>
+#include <new>
+#include <stdexcept>
 #include <utility>
 
 #if not defined(CVIP_CONFIG_LOADED)
@@ -41,6 +44,18 @@ namespace cvip
             return std::make_shared<operator_t>(*static_cast<operator_t const*>(this));
         }
 
+        template<typename ConcreteOperator>
+        inline std::size_t base_operator<ConcreteOperator>::footprint() const noexcept
+        {
+            return alignof(operator_t) <= alignof(std::max_align_t) ? sizeof(operator_t) : 0;
+        }
+
+        template<typename ConcreteOperator>
+        inline i_operator* base_operator<ConcreteOperator>::clone_into(void* storage) const
+        {
+            return ::new (storage) operator_t(*static_cast<operator_t const*>(this));
+        }
+
 
         // basic_operator<Predicate>
         //
@@ -55,13 +70,103 @@ namespace cvip
         template<typename Predicate> template<typename ...Args>
         inline basic_operator<Predicate>& cvip::core::basic_operator<Predicate>::operator()(Args&& ...arg)
         {
-            return (m_operation.reset(std::forward<Args>(arg)...), *this);
+            return (m_operation.reset(std::forward<Args>(arg)...), ++m_revision, *this);
+        }
+
+        template<typename Predicate>
+        inline Predicate const& basic_operator<Predicate>::predicate() const noexcept
+        {
+            return m_operation;
+        }
+
+        template<typename Predicate>
+        inline basic_operator<Predicate>& basic_operator<Predicate>::execution(execution_model const model) noexcept
+        {
+            m_execution = model;
+
+            return *this;
+        }
+
+        template<typename Predicate>
+        inline execution_model basic_operator<Predicate>::execution() const noexcept
+        {
+            return m_execution;
         }
 
         template<typename Predicate>
         inline void basic_operator<Predicate>::apply(matrix& dst, matrix& src, bool const first)
         {
-            m_operation.do_apply(dst, src, first);
+            detail::apply_predicate(m_operation, m_execution, dst, src, first);
+        }
+
+        template<typename Predicate>
+        inline operator_traits basic_operator<Predicate>::traits() const
+        {
+            auto traits = operator_traits{ };
+
+            traits.halo        = detail::halo_of(m_operation);
+            traits.pointwise   = detail::pointwise_depths<predicate_t>;
+            traits.identity    = detail::identity_of(m_operation);
+            traits.fingerprint = detail::fingerprint_of(m_operation);
+            traits.in_place    = detail::in_place_of(m_operation);
+
+            return traits;
+        }
+
+        template<typename Predicate>
+        inline std::optional<matrix_shape> basic_operator<Predicate>::infer(matrix_shape const& input) const
+        {
+            return detail::output_shape_of(m_operation, input);
+        }
+
+        template<typename Predicate>
+        inline std::size_t basic_operator<Predicate>::revision() const noexcept
+        {
+            return m_revision;
+        }
+
+        template<typename Predicate>
+        inline void basic_operator<Predicate>::map(void const* src, void* dst, int const count, int const depth) const
+        {
+            detail::visit_depth(depth, [&](auto const tag)
+            {
+                map_as<typename decltype(tag)::type>(src, dst, count);
+            });
+        }
+
+        template<typename Predicate> template<typename T>
+        inline void basic_operator<Predicate>::map_as(void const* src, void* dst, int const count) const
+        {
+            if constexpr (detail::has_map<predicate_t, T>::value)
+            {
+                m_operation.map(static_cast<T const*>(src), static_cast<T*>(dst), count);
+            }
+            else
+            {
+                throw std::logic_error("basic_operator: the predicate has no kernel for this depth");
+            }
+        }
+
+
+        // typed_predicate<Predicate, T>
+        //
+
+        template<typename Predicate, typename T> template<typename ...Args>
+        typed_predicate<Predicate, T>::typed_predicate(Args&& ...arg) :
+            Predicate{ std::forward<Args>(arg)... }
+        {
+            // NOOP
+        }
+
+        template<typename Predicate, typename T>
+        inline void typed_predicate<Predicate, T>::do_apply(matrix& dst, matrix& src, bool const first)
+        {
+            if (src.depth() != detail::depth_of<T>)
+            {
+                throw std::invalid_argument("typed_predicate: the image is not of the element type of the predicate");
+            }
+
+            Predicate::template do_apply_as<T>(dst, src, first);
         }
 
 
@@ -73,6 +178,11 @@ namespace cvip
             return lhs_op * rhs_im;
         }
 
+        inline matrix operator*(i_operator&& lhs_op, matrix&& rhs_im)
+        {
+            return lhs_op * std::move(rhs_im);
+        }
+
     }
 
 }
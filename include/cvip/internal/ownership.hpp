@@ -0,0 +1,68 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_OWNERSHIP_HPP
+#define CVIP_CORE_OWNERSHIP_HPP
+
+#pragma once
+
+
+#include "basic_types.hpp"
+#include <utility>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+CVIP_BEGIN_IMPLEMENTATION_DETAILS(cvip::core)
+
+    // Whether the matrix is the only reference to its data, i.e. the data
+    // may be overwritten without any other holder noticing it. Matrices on
+    // user allocated data are never considered unshared.
+    //
+    // REMARK: Other threads may copy or release the matrix meanwhile, the
+    //         reference count is read atomically, as OpenCV updates it.
+    //
+
+    inline bool unshared(matrix const& mat) noexcept
+    {
+        return mat.u != nullptr and CV_XADD(&mat.u->refcount, 0) == 1;
+    }
+
+
+    // An input owned by the executor of a chain, i.e. not the caller's
+    // image, is still given to the first stage as if it were, with first
+    // set. Unless the stage works in place, the executor holds the input
+    // while the stage runs, and hands it over to the second stage as its
+    // destination afterwards, if the stage did not return it as its result.
+    //
+
+    inline matrix hold_input(matrix const& dst, matrix const& src, bool const owned)
+    {
+        return owned and dst.data != src.data ? src : matrix{ };
+    }
+
+    inline void hand_over_input(matrix& input, matrix& dst, matrix const& src)
+    {
+        if (dst.empty() and input.data != src.data)
+        {
+            dst = std::move(input);
+        }
+
+        input = matrix{ };
+    }
+
+CVIP_END_IMPLEMENTATION_DETAILS(cvip::core)
+
+
+#endif // !CVIP_CORE_OWNERSHIP_HPP
@@ -0,0 +1,103 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_POINTWISE_HPP
+#define CVIP_CORE_POINTWISE_HPP
+
+#pragma once
+
+
+#include "basic_types.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+CVIP_BEGIN_IMPLEMENTATION_DETAILS(cvip::core)
+
+    // Tools for running the elementwise kernels of pointwise operators
+    //
+
+    template<typename T>
+    struct depth_tag
+    {
+        using type = T;
+    };
+
+
+    // Call fn with the depth_tag of the element type of the matrix depth
+    //
+
+    template<typename Fn>
+    inline decltype(auto) visit_depth(int const depth, Fn&& fn)
+    {
+        switch (depth)
+        {
+        case CV_8U:  return fn(depth_tag<upix_t>{ });
+        case CV_8S:  return fn(depth_tag<std::int8_t>{ });
+        case CV_16U: return fn(depth_tag<wpix_t>{ });
+        case CV_16S: return fn(depth_tag<std::int16_t>{ });
+        case CV_32S: return fn(depth_tag<std::int32_t>{ });
+        case CV_32F: return fn(depth_tag<float>{ });
+        case CV_64F: return fn(depth_tag<double>{ });
+        default:     throw std::logic_error("cvip: unsupported matrix depth");
+        }
+    }
+
+
+    // Create dst with the size and type of src, and call kernel(in, out, n)
+    // on cache sized spans of n elements of each row of src and dst
+    //
+
+    template<typename Kernel>
+    inline void for_each_span(matrix const& src, matrix& dst, Kernel&& kernel)
+    {
+        static auto constexpr span_bytes = std::size_t{ 16 * 1024 };
+
+        dst.create(src.rows, src.cols, src.type());
+
+        auto const esize = src.elemSize1();
+        auto const span  = static_cast<int>(std::max<std::size_t>(span_bytes / esize, 1));
+
+        auto rows = src.rows;
+        auto cols = src.cols * src.channels();
+
+        if (src.isContinuous() and dst.isContinuous())
+        {
+            cols *= rows;
+            rows  = 1;
+        }
+
+        for (auto y = 0; y < rows; ++y)
+        {
+            auto const* in  = src.ptr<upix_t>(y);
+            auto*       out = dst.ptr<upix_t>(y);
+
+            for (auto x = 0; x < cols; x += span)
+            {
+                auto const offset = static_cast<std::size_t>(x) * esize;
+
+                kernel(in + offset, out + offset, std::min(span, cols - x));
+            }
+        }
+    }
+
+CVIP_END_IMPLEMENTATION_DETAILS(cvip::core)
+
+
+#endif // !CVIP_CORE_POINTWISE_HPP
@@ -0,0 +1,234 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_PREDICATE_TRAITS_HPP
+#define CVIP_CORE_PREDICATE_TRAITS_HPP
+
+#pragma once
+
+
+#include "basic_types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+CVIP_BEGIN_IMPLEMENTATION_DETAILS(cvip::core)
+
+    // Tools for detecting the optional capabilities of operator predicates
+    //
+
+    template<typename P, typename = void>
+    struct has_halo : std::false_type { };
+
+    template<typename P>
+    struct has_halo<P, std::void_t<decltype(std::declval<P const&>().halo())>> : std::true_type { };
+
+    template<typename P, typename = void>
+    struct has_row_halo : std::false_type { };
+
+    template<typename P>
+    struct has_row_halo<P, std::void_t<decltype(std::declval<P const&>().row_halo())>> : std::true_type { };
+
+    template<typename P, typename = void>
+    struct has_output_shape : std::false_type { };
+
+    template<typename P>
+    struct has_output_shape<P, std::void_t<decltype(std::declval<P const&>().output_shape(
+                                   std::declval<matrix_shape const&>()))>> : std::true_type { };
+
+    template<typename P, typename = void>
+    struct has_identity : std::false_type { };
+
+    template<typename P>
+    struct has_identity<P, std::void_t<decltype(std::declval<P const&>().identity())>> : std::true_type { };
+
+    template<typename P, typename = void>
+    struct has_fingerprint : std::false_type { };
+
+    template<typename P>
+    struct has_fingerprint<P, std::void_t<decltype(std::declval<P const&>().fingerprint())>> : std::true_type { };
+
+    template<typename P, typename = void>
+    struct has_in_place : std::false_type { };
+
+    template<typename P>
+    struct has_in_place<P, std::void_t<decltype(std::declval<P const&>().in_place())>> : std::true_type { };
+
+    template<typename P, typename T, typename = void>
+    struct has_map : std::false_type { };
+
+    template<typename P, typename T>
+    struct has_map<P, T, std::void_t<decltype(std::declval<P const&>().map(std::declval<T const*>(),
+                                                                            std::declval<T*>(), 0))>>
+        : std::true_type { };
+
+    template<typename P, typename T, typename = void>
+    struct has_apply_as : std::false_type { };
+
+    template<typename P, typename T>
+    struct has_apply_as<P, T, std::void_t<decltype(std::declval<P&>().template do_apply_as<T>(
+                                  std::declval<matrix&>(), std::declval<matrix&>(), true))>> : std::true_type { };
+
+
+    // Matrix depths for which the predicate has an elementwise kernel, as a
+    // mask of (1 << depth) bits, see operator_traits::pointwise
+    //
+
+    template<typename P>
+    inline constexpr auto pointwise_depths = (has_map<P, upix_t>::value       ? 1u << CV_8U  : 0u)
+                                           | (has_map<P, std::int8_t>::value  ? 1u << CV_8S  : 0u)
+                                           | (has_map<P, wpix_t>::value       ? 1u << CV_16U : 0u)
+                                           | (has_map<P, std::int16_t>::value ? 1u << CV_16S : 0u)
+                                           | (has_map<P, std::int32_t>::value ? 1u << CV_32S : 0u)
+                                           | (has_map<P, float>::value        ? 1u << CV_32F : 0u)
+                                           | (has_map<P, double>::value       ? 1u << CV_64F : 0u);
+
+
+    // Matrix depths for which the predicate has a typed kernel, as a mask of
+    // (1 << depth) bits, see i_operator_predicate::do_apply_as
+    //
+
+    template<typename P>
+    inline constexpr auto typed_depths = (has_apply_as<P, upix_t>::value       ? 1u << CV_8U  : 0u)
+                                       | (has_apply_as<P, std::int8_t>::value  ? 1u << CV_8S  : 0u)
+                                       | (has_apply_as<P, wpix_t>::value       ? 1u << CV_16U : 0u)
+                                       | (has_apply_as<P, std::int16_t>::value ? 1u << CV_16S : 0u)
+                                       | (has_apply_as<P, std::int32_t>::value ? 1u << CV_32S : 0u)
+                                       | (has_apply_as<P, float>::value        ? 1u << CV_32F : 0u)
+                                       | (has_apply_as<P, double>::value       ? 1u << CV_64F : 0u);
+
+    // Neighbourhood radius of the predicate, see operator_traits::halo, a
+    // pointwise predicate is local with no neighbourhood
+    //
+
+    template<typename P>
+    inline int halo_of(P const& pr [[maybe_unused]])
+    {
+        if constexpr (has_halo<P>::value)
+        {
+            return pr.halo();
+        }
+        else if constexpr (pointwise_depths<P> != 0u)
+        {
+            return 0;
+        }
+        else
+        {
+            return -1;
+        }
+    }
+
+
+    // Shape of the output of the predicate on an input of the given shape,
+    // see i_operator::infer, a pointwise predicate preserves the shape of
+    // the inputs it has a kernel for
+    //
+
+    template<typename P>
+    inline std::optional<matrix_shape> output_shape_of(P const& pr [[maybe_unused]], matrix_shape const& input)
+    {
+        if constexpr (has_output_shape<P>::value)
+        {
+            return pr.output_shape(input);
+        }
+        else if constexpr (pointwise_depths<P> != 0u)
+        {
+            if ((pointwise_depths<P> & (1u << CV_MAT_DEPTH(input.type))) != 0u)
+            {
+                return input;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+
+    // Mix a value into a hash
+    //
+
+    inline std::size_t hash_combine(std::size_t const seed, std::size_t const value) noexcept
+    {
+        return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+    }
+
+
+    // Fingerprint of the predicate, see operator_traits::fingerprint, the
+    // type is enough for a predicate with no state
+    //
+
+    template<typename P>
+    inline std::optional<std::size_t> fingerprint_of(P const& pr [[maybe_unused]])
+    {
+        auto const type = typeid(P).hash_code();
+
+        if constexpr (has_fingerprint<P>::value)
+        {
+            return hash_combine(type, static_cast<std::size_t>(pr.fingerprint()));
+        }
+        else if constexpr (std::is_empty_v<P>)
+        {
+            return type;
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+
+    // Whether the predicate may be applied in place, see
+    // operator_traits::in_place
+    //
+
+    template<typename P>
+    inline bool in_place_of(P const& pr [[maybe_unused]])
+    {
+        if constexpr (has_in_place<P>::value)
+        {
+            return pr.in_place();
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+
+    // Whether the predicate leaves its input unchanged, see
+    // operator_traits::identity
+    //
+
+    template<typename P>
+    inline bool identity_of(P const& pr [[maybe_unused]])
+    {
+        if constexpr (has_identity<P>::value)
+        {
+            return pr.identity();
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+CVIP_END_IMPLEMENTATION_DETAILS(cvip::core)
+
+
+#endif // !CVIP_CORE_PREDICATE_TRAITS_HPP
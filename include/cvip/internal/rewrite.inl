@@ -0,0 +1,94 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_REWRITE_INL
+#define CVIP_CORE_REWRITE_INL
+
+#pragma once
+
+
+#include "../rewrite.hpp"
+#include <type_traits>
+#include <utility>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        // rewrite_as
+        //
+
+        template<typename ...Operators>
+        inline rewrite_t rewrite_as(Operators&& ...ops)
+        {
+            static_assert((is_operator<std::decay_t<Operators>>::value and ...), "not an i_operator");
+
+            return operator_chain{ std::make_shared<std::decay_t<Operators>>(std::forward<Operators>(ops))... };
+        }
+
+
+        // rewrite_rules
+        //
+
+        template<typename Operator, typename Rule, typename>
+        inline void rewrite_rules::add(Rule&& rule)
+        {
+            static_assert(is_operator<Operator>::value, "Operator is not an i_operator");
+
+            add_unary(typeid(Operator), [rule = std::forward<Rule>(rule)](i_operator const& op) -> rewrite_t
+            {
+                return rule(static_cast<Operator const&>(op));
+            });
+        }
+
+        template<typename First, typename Second, typename Rule>
+        inline void rewrite_rules::add(Rule&& rule)
+        {
+            static_assert(is_operator<First>::value, "First is not an i_operator");
+            static_assert(is_operator<Second>::value, "Second is not an i_operator");
+
+            add_binary({ typeid(First), typeid(Second) },
+                       [rule = std::forward<Rule>(rule)](i_operator const& first, i_operator const& second) -> rewrite_t
+            {
+                return rule(static_cast<First const&>(first), static_cast<Second const&>(second));
+            });
+        }
+
+
+        // add_rewrite_rule
+        //
+
+        template<typename Operator, typename Rule, typename>
+        inline void add_rewrite_rule(Rule&& rule)
+        {
+            rewrite_rules::global().add<Operator>(std::forward<Rule>(rule));
+        }
+
+        template<typename First, typename Second, typename Rule>
+        inline void add_rewrite_rule(Rule&& rule)
+        {
+            rewrite_rules::global().add<First, Second>(std::forward<Rule>(rule));
+        }
+
+    }
+
+}
+
+
+#endif // !CVIP_CORE_REWRITE_INL
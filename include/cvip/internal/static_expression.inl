@@ -0,0 +1,375 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_STATIC_EXPRESSION_INL
+#define CVIP_CORE_STATIC_EXPRESSION_INL
+
+#pragma once
+
+
+#include "../static_expression.hpp"
+#include "basic_imports.hpp"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        // static_expression<Predicates...>
+        //
+
+        template<typename ...Predicates>
+        inline static_expression<Predicates...>::static_expression(chain_t&& chain, models_t const& models) :
+            m_chain{ std::move(chain) },
+            m_models{ models }
+        {
+            // NOOP
+        }
+
+        template<typename ...Predicates>
+        inline void static_expression<Predicates...>::apply(matrix& dst, matrix& src, bool const first)
+        {
+            apply_chain(dst, src, first, false, std::index_sequence_for<Predicates...>{ });
+
+            // REMARK: The result is in src due to the swap at the end of
+            //         each stage, give it back in dst as i_operator::apply
+            //         requires.
+
+            cvip::swap(dst, src);
+        }
+
+        template<typename ...Predicates>
+        inline operator_traits static_expression<Predicates...>::traits() const
+        {
+            // REMARK: The chain is local only if every stage is local, its
+            //         halo is the sum of the halos of all stages.
+
+            auto traits = operator_traits{ };
+
+            auto const stage = [&traits](auto const& pr)
+            {
+                auto const halo = detail::halo_of(pr);
+
+                auto const fingerprint = detail::fingerprint_of(pr);
+
+                traits.halo     = (traits.halo < 0 or halo < 0) ? -1 : traits.halo + halo;
+                traits.identity = traits.identity and detail::identity_of(pr);
+                traits.in_place = traits.in_place and detail::in_place_of(pr);
+
+                if (traits.fingerprint and fingerprint)
+                {
+                    traits.fingerprint = detail::hash_combine(*traits.fingerprint, *fingerprint);
+                }
+                else
+                {
+                    traits.fingerprint = std::nullopt;
+                }
+            };
+
+            traits.halo        = 0;
+            traits.pointwise   = pointwise_depths;
+            traits.identity    = true;
+            traits.in_place    = true;
+            traits.fingerprint = typeid(static_expression).hash_code();
+
+            std::apply([&stage](auto const& ...pr) { (stage(pr), ...); }, m_chain);
+
+            return traits;
+        }
+
+        template<typename ...Predicates>
+        inline std::optional<matrix_shape> static_expression<Predicates...>::infer(matrix_shape const& input) const
+        {
+            auto shape = std::optional<matrix_shape>{ input };
+
+            auto const stage = [&shape](auto const& pr)
+            {
+                if (shape)
+                {
+                    shape = detail::output_shape_of(pr, *shape);
+                }
+            };
+
+            std::apply([&stage](auto const& ...pr) { (stage(pr), ...); }, m_chain);
+
+            return shape;
+        }
+
+        template<typename ...Predicates>
+        inline void static_expression<Predicates...>::map(void const* src, void* dst, int const count,
+                                                          int const depth) const
+        {
+            detail::visit_depth(depth, [&](auto const tag)
+            {
+                using element_t = typename decltype(tag)::type;
+
+                if constexpr ((detail::has_map<Predicates, element_t>::value and ...))
+                {
+                    map_chain(static_cast<element_t const*>(src), static_cast<element_t*>(dst), count,
+                              std::index_sequence_for<Predicates...>{ });
+                }
+                else
+                {
+                    throw std::logic_error("static_expression: the chain has no kernel for this depth");
+                }
+            });
+        }
+
+        template<typename ...Predicates>
+        inline matrix static_expression<Predicates...>::apply(matrix const& rhs_im)
+        {
+            auto src = matrix{ rhs_im };
+            auto dst = matrix{ };
+
+            apply_chain(dst, src, true, false, std::index_sequence_for<Predicates...>{ });
+
+            // REMARK: The result is in src due to the swap
+            //         at the end of each stage!
+
+            return src;
+        }
+
+        template<typename ...Predicates>
+        inline matrix static_expression<Predicates...>::apply(matrix&& rhs_im)
+        {
+            auto src = matrix{ std::move(rhs_im) };
+            auto dst = matrix{ };
+
+            // REMARK: An input owned by the expression is not the caller's
+            //         image, see operator_expression::compute.
+
+            apply_chain(dst, src, true, detail::unshared(src), std::index_sequence_for<Predicates...>{ });
+
+            return src;
+        }
+
+        template<typename ...Predicates> template<std::size_t ...I>
+        inline void static_expression<Predicates...>::apply_chain(matrix& dst, matrix& src, bool const first,
+                                                                  bool const owned, std::index_sequence<I...>)
+        {
+            if (not src.empty() and (pointwise_depths & (1u << src.depth())) != 0u)
+            {
+                apply_fused(dst, src, first);
+
+                return;
+            }
+
+            auto is_first = first;
+
+            auto input = matrix{ };
+
+            auto const stage = [&dst, &src, &is_first, &input, owned](auto& pr, execution_model const model)
+            {
+                if (detail::in_place_of(pr) and detail::unshared(src))
+                {
+                    dst = src;
+                }
+
+                if (is_first)
+                {
+                    input = detail::hold_input(dst, src, owned);
+                }
+
+                detail::apply_predicate(pr, model, dst, src, is_first);
+
+                cvip::swap(dst, src);
+
+                // REMARK: After an in-place stage both may be on the same
+                //         buffer, see operator_expression::apply_chain.
+
+                if (dst.data == src.data)
+                {
+                    dst = matrix{ };
+                }
+
+                detail::hand_over_input(input, dst, src);
+
+                is_first = false;
+            };
+
+            (stage(std::get<I>(m_chain), std::get<I>(m_models)), ...);
+        }
+
+        template<typename ...Predicates>
+        inline void static_expression<Predicates...>::apply_fused(matrix& dst, matrix& src, bool const first)
+        {
+            // REMARK: The kernels work in place, do so if src is not shared.
+
+            if (detail::unshared(src))
+            {
+                dst = src;
+            }
+
+            detail::visit_depth(src.depth(), [&](auto const tag)
+            {
+                using element_t = typename decltype(tag)::type;
+
+                if constexpr ((detail::has_map<Predicates, element_t>::value and ...))
+                {
+                    detail::for_each_span(src, dst, [this](void const* in, void* out, int const count)
+                    {
+                        map_chain(static_cast<element_t const*>(in), static_cast<element_t*>(out), count,
+                                  std::index_sequence_for<Predicates...>{ });
+                    });
+                }
+            });
+
+            if (first)
+            {
+                src = matrix{ };
+            }
+
+            // REMARK: Leave the result in src, as the stages would do.
+
+            cvip::swap(dst, src);
+        }
+
+        template<typename ...Predicates> template<typename T, std::size_t ...I>
+        inline void static_expression<Predicates...>::map_chain(T const* src, T* dst, int const count,
+                                                                std::index_sequence<I...>) const
+        {
+            // REMARK: The first kernel reads src, the others update dst
+            //         in place.
+
+            (std::get<I>(m_chain).map(I == 0 ? src : dst, dst, count), ...);
+        }
+
+        template<typename ...Predicates> template<typename Predicate>
+        inline std::tuple<Predicate> static_expression<Predicates...>::chain_of(basic_operator<Predicate> const& op)
+        {
+            return std::tuple<Predicate>{ op.m_operation };
+        }
+
+        template<typename ...Predicates> template<typename Predicate>
+        inline std::array<execution_model, 1> static_expression<Predicates...>::models_of(
+            basic_operator<Predicate> const& op)
+        {
+            return { op.m_execution };
+        }
+
+        template<typename ...Predicates> template<std::size_t N, std::size_t M>
+        inline typename static_expression<Predicates...>::models_t static_expression<Predicates...>::join(
+            std::array<execution_model, N> const& first, std::array<execution_model, M> const& second)
+        {
+            static_assert(N + M == sizeof...(Predicates), "join: wrong number of execution models");
+
+            auto models = models_t{ };
+
+            std::copy(first.begin(), first.end(), models.begin());
+            std::copy(second.begin(), second.end(), models.begin() + N);
+
+            return models;
+        }
+
+
+        // make_static
+        //
+
+        template<typename Predicate>
+        inline static_expression<Predicate> make_static(basic_operator<Predicate> const& op)
+        {
+            using result_t = static_expression<Predicate>;
+
+            return result_t{ result_t::chain_of(op), result_t::models_of(op) };
+        }
+
+        template<typename First, typename Second, typename ...Rest>
+        inline auto make_static(basic_operator<First> const& first, basic_operator<Second> const& second,
+                                basic_operator<Rest> const& ...rest)
+        {
+            return ((make_static(first) * make_static(second)) * ... * make_static(rest));
+        }
+
+
+        // static_expression operator* (ex * op, op * ex)
+        //
+
+        template<typename ...Lhs, typename Rhs>
+        inline static_expression<Rhs, Lhs...> operator*(static_expression<Lhs...> const& lhs_ex,
+                                                        basic_operator<Rhs> const& rhs_op)
+        {
+            using result_t = static_expression<Rhs, Lhs...>;
+
+            return result_t{ std::tuple_cat(result_t::chain_of(rhs_op), lhs_ex.m_chain),
+                             result_t::join(result_t::models_of(rhs_op), lhs_ex.m_models) };
+        }
+
+        template<typename Lhs, typename ...Rhs>
+        inline static_expression<Rhs..., Lhs> operator*(basic_operator<Lhs> const& lhs_op,
+                                                        static_expression<Rhs...> const& rhs_ex)
+        {
+            using result_t = static_expression<Rhs..., Lhs>;
+
+            return result_t{ std::tuple_cat(rhs_ex.m_chain, result_t::chain_of(lhs_op)),
+                             result_t::join(rhs_ex.m_models, result_t::models_of(lhs_op)) };
+        }
+
+
+        // static_expression operator* (ex * ex)
+        //
+
+        template<typename ...Lhs, typename ...Rhs>
+        inline static_expression<Rhs..., Lhs...> operator*(static_expression<Lhs...> const& lhs_ex,
+                                                           static_expression<Rhs...> const& rhs_ex)
+        {
+            using result_t = static_expression<Rhs..., Lhs...>;
+
+            return result_t{ std::tuple_cat(rhs_ex.m_chain, lhs_ex.m_chain),
+                             result_t::join(rhs_ex.m_models, lhs_ex.m_models) };
+        }
+
+
+        // static_expression operator* (ex * matrix)
+        //
+
+        template<typename ...Predicates>
+        inline matrix operator*(static_expression<Predicates...>& lhs_ex, matrix const& rhs_im)
+        {
+            return lhs_ex.apply(rhs_im);
+        }
+
+        template<typename ...Predicates>
+        inline matrix operator*(static_expression<Predicates...>&& lhs_ex, matrix const& rhs_im)
+        {
+            return lhs_ex * rhs_im;
+        }
+
+        template<typename ...Predicates>
+        inline matrix operator*(static_expression<Predicates...>& lhs_ex, matrix&& rhs_im)
+        {
+            return lhs_ex.apply(std::move(rhs_im));
+        }
+
+        template<typename ...Predicates>
+        inline matrix operator*(static_expression<Predicates...>&& lhs_ex, matrix&& rhs_im)
+        {
+            return lhs_ex * std::move(rhs_im);
+        }
+
+    }
+
+}
+
+
+#endif // !CVIP_CORE_STATIC_EXPRESSION_INL
@@ -0,0 +1,111 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_STRIPING_HPP
+#define CVIP_CORE_STRIPING_HPP
+
+#pragma once
+
+
+#include "basic_types.hpp"
+#include "predicate_traits.hpp"
+#include "typed_dispatch.hpp"
+#include <functional>
+#include <optional>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+CVIP_BEGIN_IMPLEMENTATION_DETAILS(cvip::core)
+
+    // Tools for applying row separable predicates on horizontal stripes
+    //
+
+    using stripe_fn = std::function<void(matrix& dst, matrix& src)>;
+
+
+    // Number of stripes worth applying in parallel on src, one if the image
+    // is too small to pay for the dispatch
+    //
+
+    int stripe_count(matrix const& src, int const row_halo);
+
+
+    // Apply stage on the given number of stripes of src, each one grown by
+    // row_halo rows above and below, in parallel, and assemble the rows of
+    // each result that belong to its stripe in dst. Follows the protocol of
+    // i_operator::apply, stage is applied as on the caller's image. When the
+    // shape of the result is given, stripes without halo are staged straight
+    // into their rows of dst.
+    //
+
+    void apply_striped(matrix& dst, matrix& src, int const row_halo, int const stripes, bool const first,
+                       std::optional<matrix_shape> const& shape, stripe_fn const& stage);
+
+
+    // Apply the predicate with stage(pr, dst, src, first) as basic_operator
+    // does, striped if it is row separable and the execution model is
+    // parallel
+    //
+
+    template<typename P, typename Stage>
+    inline void apply_stage(P& pr, execution_model const model, matrix& dst, matrix& src, bool const first,
+                            Stage const& stage)
+    {
+        if constexpr (has_row_halo<P>::value)
+        {
+            auto const row_halo = pr.row_halo();
+            auto const stripes  = model == execution_model::parallel ? stripe_count(src, row_halo) : 1;
+
+            if (stripes > 1)
+            {
+                auto const shape = output_shape_of(pr, { src.rows, src.cols, src.type() });
+
+                apply_striped(dst, src, row_halo, stripes, first, shape, [&pr, &stage](matrix& out, matrix& in)
+                {
+                    stage(pr, out, in, true);
+                });
+
+                return;
+            }
+        }
+
+        stage(pr, dst, src, first);
+    }
+
+
+    // Apply the predicate as basic_operator does, with the typed kernel for
+    // the depth of src, chosen once for all the stripes, if it has some
+    //
+
+    template<typename P>
+    inline void apply_predicate(P& pr, execution_model const model, matrix& dst, matrix& src, bool const first)
+    {
+        if constexpr (typed_depths<P> != 0u)
+        {
+            apply_stage(pr, model, dst, src, first, typed_kernel<P>(src.depth()));
+        }
+        else
+        {
+            apply_stage(pr, model, dst, src, first, [](P& p, matrix& out, matrix& in, bool const is_first)
+            {
+                p.do_apply(out, in, is_first);
+            });
+        }
+    }
+
+CVIP_END_IMPLEMENTATION_DETAILS(cvip::core)
+
+
+#endif // !CVIP_CORE_STRIPING_HPP
@@ -0,0 +1,116 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+
+#ifndef CVIP_CORE_TYPED_DISPATCH_HPP
+#define CVIP_CORE_TYPED_DISPATCH_HPP
+
+#pragma once
+
+
+#include "basic_types.hpp"
+#include "predicate_traits.hpp"
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+CVIP_BEGIN_IMPLEMENTATION_DETAILS(cvip::core)
+
+    // Tools for dispatching on the typed kernels of predicates, see
+    // i_operator_predicate::do_apply_as
+    //
+
+    template<typename P>
+    using typed_kernel_t = void (*)(P& pr, matrix& dst, matrix& src, bool const first);
+
+
+    // Matrix depth of the element type T
+    //
+
+    template<typename T>
+    inline constexpr int depth_of = std::is_same_v<T, upix_t>       ? CV_8U
+                                  : std::is_same_v<T, std::int8_t>  ? CV_8S
+                                  : std::is_same_v<T, wpix_t>       ? CV_16U
+                                  : std::is_same_v<T, std::int16_t> ? CV_16S
+                                  : std::is_same_v<T, std::int32_t> ? CV_32S
+                                  : std::is_same_v<T, float>        ? CV_32F
+                                  : std::is_same_v<T, double>       ? CV_64F
+                                  : -1;
+
+
+    // Call the typed kernel of the predicate for the element type T
+    //
+
+    template<typename P, typename T>
+    inline void apply_as(P& pr, matrix& dst, matrix& src, bool const first)
+    {
+        pr.template do_apply_as<T>(dst, src, first);
+    }
+
+    template<typename P, typename T>
+    constexpr typed_kernel_t<P> typed_kernel_for() noexcept
+    {
+        if constexpr (has_apply_as<P, T>::value)
+        {
+            return &apply_as<P, T>;
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+
+
+    // Kernels of the predicate indexed by matrix depth, built at compile
+    // time, null for the depths it has no kernel for
+    //
+
+    template<typename P>
+    inline constexpr typed_kernel_t<P> typed_kernels[] = {
+        typed_kernel_for<P, upix_t>(),
+        typed_kernel_for<P, std::int8_t>(),
+        typed_kernel_for<P, wpix_t>(),
+        typed_kernel_for<P, std::int16_t>(),
+        typed_kernel_for<P, std::int32_t>(),
+        typed_kernel_for<P, float>(),
+        typed_kernel_for<P, double>()
+    };
+
+
+    // Kernel of the predicate for the matrix depth, it throws if there is
+    // none
+    //
+
+    template<typename P>
+    inline typed_kernel_t<P> typed_kernel(int const depth)
+    {
+        auto const count  = static_cast<int>(std::size(typed_kernels<P>));
+        auto const kernel = 0 <= depth and depth < count ? typed_kernels<P>[depth] : nullptr;
+
+        if (kernel == nullptr)
+        {
+            throw std::invalid_argument("basic_operator: the predicate has no kernel for the depth of the image");
+        }
+
+        return kernel;
+    }
+
+CVIP_END_IMPLEMENTATION_DETAILS(cvip::core)
+
+
+#endif // !CVIP_CORE_TYPED_DISPATCH_HPP
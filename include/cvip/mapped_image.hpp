@@ -0,0 +1,128 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+
+#ifndef CVIP_CORE_MAPPED_IMAGE_HPP
+#define CVIP_CORE_MAPPED_IMAGE_HPP
+
+#pragma once
+
+
+#include "internal/basic_types.hpp"
+#include <cstddef>
+#include <string>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        // Memory-mapped raw image
+        //
+        // Maps an image stored as raw, row major, tightly packed pixels in a
+        // file, optionally after a header of a fixed size. The pixels are in
+        // the native byte order, so, e.g. the big endian data of FITS files
+        // must be converted first.
+        // Rows are accessed as matrices over the mapped memory, so that only
+        // the pages actually touched are read from, or written to, the file,
+        // and pages no longer needed can be dropped from memory.
+        //
+        // A read_write mapping creates the file if it does not exist and
+        // grows it to hold the whole image; the header bytes, if any, are left
+        // for the caller to write.
+        //
+        // The matrices returned by rows() share the mapped memory, so they
+        // must not outlive the mapped image.
+        //
+
+        class mapped_image
+        {
+        public:
+
+            enum class access : int
+            {
+                read_only,
+                read_write,
+            };
+
+
+        public:
+
+            mapped_image(std::string const& path, matrix_shape const& shape, access const mode = access::read_only,
+                         std::size_t const offset = 0);
+
+            mapped_image(mapped_image const& src) = delete;
+
+            mapped_image(mapped_image&& src) noexcept;
+
+            // Unmaps the image, a read_write image is flushed to its file
+            //
+            ~mapped_image() noexcept;
+
+            mapped_image& operator=(mapped_image const& src) = delete;
+
+            mapped_image& operator=(mapped_image&& src) noexcept;
+
+
+        public:
+
+            matrix_shape const& shape() const noexcept;
+
+            // Matrix over count rows from the given one
+            //
+            matrix rows(int const first, int const count) const;
+
+            // Let the system drop the pages of count rows from the given one
+            // from memory, written pages are kept in the file
+            //
+            void release(int const first, int const count) const noexcept;
+
+            // Write the modified pages to the file
+            //
+            void flush() const;
+
+
+        private:
+
+            void unmap() noexcept;
+
+
+        private:
+
+            matrix_shape m_shape = { };
+
+            std::size_t m_step = 0;  // bytes per row
+
+            unsigned char* m_view = nullptr;  // start of the mapping
+
+            unsigned char* m_data = nullptr;  // first pixel
+
+            std::size_t m_length = 0;  // bytes mapped
+
+            access m_mode = access::read_only;
+
+            void* m_handle = nullptr;  // platform mapping handle, if any
+
+        };
+
+    }
+
+}
+
+
+#endif // !CVIP_CORE_MAPPED_IMAGE_HPP
@@ -0,0 +1,160 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+
+#ifndef CVIP_CORE_NUMA_HPP
+#define CVIP_CORE_NUMA_HPP
+
+#pragma once
+
+
+#include "allocator.hpp"
+#include "scheduler.hpp"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    // NUMA aware scheduling
+    //
+    // On a host with several NUMA nodes, e.g. a dual socket one, a thread pool
+    // applying an expression on a batch of frames spends much of its time on
+    // cross node memory traffic: a frame is processed by threads on either
+    // socket, on intermediate results first touched by either of them. A
+    // numa_scheduler has a set of workers per node, pinned to the processors
+    // of the node, and a matrix allocator per node, see allocator.hpp:
+    //
+    //      auto scheduler = numa_scheduler{ };
+    //
+    //      auto const results = batch_apply(ex, frames, scheduler);
+    //
+    // Each frame is processed, the whole chain, by a single worker, in the
+    // scope of the allocator of its node, so that its intermediate results
+    // are allocated, and first touched, on the local node, and reused there
+    // by the next frames.
+    //
+    // The nodes are discovered from the operating system, as far as the
+    // process may run on their processors. Where the topology is not known,
+    // the scheduler has a single node, and its workers are not pinned.
+    //
+    // The pool of each allocator is bounded, see matrix_allocator::capacity.
+    // The results of a batch are allocated by the default allocator, not in
+    // the pools, so that their blocks are reused by the next frames. A batch
+    // must not be run from the workers of the same scheduler.
+    //
+
+    namespace core
+    {
+
+        class numa_scheduler
+        {
+        public:
+
+            // Frame processing function of a worker
+            //
+            using worker_t = std::function<void(std::size_t frame)>;
+
+
+        public:
+
+            // Default capacity of the pool of the allocator of each node
+            //
+            static constexpr auto default_pool_capacity = std::size_t{ 256 * 1024 * 1024 };
+
+
+        public:
+
+            // Zero workers per node means one per processor of the node, the
+            // allocators of the nodes use huge pages if asked to, and keep up
+            // to pool_capacity bytes for reuse
+            //
+            explicit numa_scheduler(std::size_t const workers_per_node = 0, bool const huge_pages = false,
+                                    std::size_t const pool_capacity = default_pool_capacity);
+
+            numa_scheduler(numa_scheduler const& src) = delete;
+
+            numa_scheduler(numa_scheduler&& src) = delete;
+
+            ~numa_scheduler() noexcept = default;
+
+            numa_scheduler& operator=(numa_scheduler const& src) = delete;
+
+            numa_scheduler& operator=(numa_scheduler&& src) = delete;
+
+
+        public:
+
+            // Process wide scheduler, with a worker per processor
+            //
+            static numa_scheduler& global();
+
+            // Number of nodes
+            //
+            std::size_t nodes() const noexcept;
+
+            // Number of workers, of all the nodes
+            //
+            std::size_t workers() const noexcept;
+
+            // Processors the workers of the node are pinned to, none if they
+            // are not pinned
+            //
+            std::vector<int> const& processors(std::size_t const node) const;
+
+            // Allocator of the node
+            //
+            matrix_allocator const& allocator(std::size_t const node) const;
+
+            // Call worker(frame) for each frame of a batch of the given size,
+            // on the workers of all the nodes, and wait for them; make_worker
+            // is called once per worker taking part, in its thread, and in
+            // the scope of the allocator of its node. If a worker throws, the
+            // remaining frames are skipped and the first exception rethrown.
+            //
+            void run(std::size_t const frames, std::function<worker_t()> const& make_worker);
+
+
+        private:
+
+            struct node_t
+            {
+                node_t(std::vector<int> cpus, std::size_t const workers, bool const huge_pages,
+                       std::size_t const pool_capacity);
+
+                std::vector<int> processors = { };
+
+                matrix_allocator allocator;
+
+                task_scheduler scheduler;  // last, so that it finishes its work first
+            };
+
+
+        private:
+
+            std::vector<std::unique_ptr<node_t>> m_nodes = { };
+
+        };
+
+    }
+
+}
+
+
+#endif // !CVIP_CORE_NUMA_HPP
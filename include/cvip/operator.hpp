@@ -17,6 +17,11 @@
 
 
 #include "i_operator.hpp"
+#include "internal/ownership.hpp"
+#include "internal/pointwise.hpp"
+#include "internal/predicate_traits.hpp"
+#include "internal/striping.hpp"
+#include "internal/typed_dispatch.hpp"
 
 #if not defined(CVIP_CONFIG_LOADED)
 #error ERROR: Missing config.hpp
@@ -29,6 +34,10 @@ namespace cvip
     namespace core
     {
 
+        template<typename ...Predicates>
+        class static_expression;
+
+
         // Generic abstract base class for image matrix operators, partially
         // implements i_operator providing cloning facility via CRT Pattern.
         //
@@ -57,11 +66,22 @@ namespace cvip
 
             virtual opnode_t clone() const override;
 
+            virtual std::size_t footprint() const noexcept override;
+
+            virtual i_operator* clone_into(void* storage) const override;
+
         };
 
 
         // Predicate based image operator
         //
+        // When the predicate is row separable (see i_operator_predicate) and
+        // the execution model of the operator is parallel, the default, large
+        // images are split in horizontal stripes, grown by the row halo of
+        // the predicate, that are processed with cv::parallel_for_. With
+        // execution_model::sequential the predicate is applied on the whole
+        // image in the calling thread.
+        //
 
         template<typename Predicate>
         class basic_operator : public base_operator< basic_operator<Predicate> >
@@ -74,32 +94,95 @@ namespace cvip
             template<typename ...Args>
             basic_operator& operator()(Args&& ...arg);
 
+            // The operator predicate, e.g. for rewrite rules
+            //
+            Predicate const& predicate() const noexcept;
+
+            // Choose between striped and whole image application
+            //
+            basic_operator& execution(execution_model const model) noexcept;
+
+            execution_model execution() const noexcept;
+
 
         protected:
 
             virtual void apply(matrix& dst, matrix& src, bool const first) override;
 
+            virtual operator_traits traits() const override;
+
+            virtual std::optional<matrix_shape> infer(matrix_shape const& input) const override;
+
+            virtual std::size_t revision() const noexcept override;
+
+            virtual void map(void const* src, void* dst, int const count, int const depth) const override;
+
 
         private:
 
             using predicate_t = Predicate;
 
+            template<typename T>
+            void map_as(void const* src, void* dst, int const count) const;
+
             static_assert(is_operator_predicate<predicate_t>::value,
                           "predicate_t does not implement i_operator_predicate");
 
 
+        private:
+
+            template<typename ...Predicates>
+            friend class static_expression;
+
+
         private:
 
             predicate_t m_operation = { };
 
+            std::size_t m_revision = 0;
+
+            execution_model m_execution = execution_model::parallel;
+
         };
 
+
+        // Predicate bound to a single element type
+        //
+        // Applies the typed kernel of the predicate for T directly, see
+        // i_operator_predicate::do_apply_as, for chains of operators on
+        // images of a depth known in advance. There is no dispatch on the
+        // depth of the image, neither per pixel nor per call, so that a
+        // static_expression of typed operators may be inlined as a whole;
+        // an image of another depth is rejected.
+        //
+
+        template<typename Predicate, typename T>
+        class typed_predicate : public Predicate
+        {
+        public:
+
+            template<typename ...Args>
+            typed_predicate(Args&& ...arg);
+
+            void do_apply(matrix& dst, matrix& src, bool const first);
+
+            template<typename U>
+            void do_apply_as(matrix& dst, matrix& src, bool const first) = delete;
+
+            static_assert(detail::has_apply_as<Predicate, T>::value, "Predicate has no typed kernel for T");
+
+        };
+
+        template<typename Predicate, typename T>
+        using typed_operator = basic_operator<typed_predicate<Predicate, T>>;
+
     }
 
 }
 
 
 #include "internal/operator.inl"
+#include "static_expression.hpp"
 
 
 #endif // !CVIP_CORE_OPERATOR_HPP
@@ -0,0 +1,334 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_PROFILING_HPP
+#define CVIP_CORE_PROFILING_HPP
+
+#pragma once
+
+
+#include "i_operator.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <typeindex>
+#include <vector>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    // Per stage instrumentation
+    //
+    // When the library is built with CVIP_CONFIG_ENABLE_PROFILING defined,
+    // every operator application made by operator*(i_operator&, matrix) and
+    // by operator_expression::apply is reported to the stage observer  set
+    // with set_stage_observer, if any.  Without that definition,  the hooks
+    // are not compiled in at all. The Profile configuration of the solution
+    // is the Release one with that definition.
+    //
+    // The stage_profiler observer aggregates  the  records  per  operator
+    // type, e.g. basic_operator<invert_predicate>, including  a  histogram
+    // of the wall time of the stages.
+    //
+    // An observer may also ask for the hardware event counts of the stages,
+    // see i_stage_observer::counting: cycles, instructions, cache misses and
+    // last level cache loads and stores, as counted by perf_event_open  for
+    // the thread applying the operator and for the cv::parallel_for_ workers
+    // running its stripes, see basic_operator. They tell compute bound ones,
+    // with many instructions per cycle, from memory bound ones, with many
+    // cache misses per byte, i.e. where fusion or tiling pays off. Counters
+    // are only available on Linux, and only where the system lets a process
+    // count its own events, see /proc/sys/kernel/perf_event_paranoid.
+    //
+
+    namespace core
+    {
+
+        // Size and type of a matrix
+        //
+
+        using stage_shape = matrix_shape;
+
+
+        // Hardware event counts of a stage, zero for the events the processor
+        // does not count
+        //
+
+        struct stage_counters
+        {
+            std::uint64_t cycles = 0;
+            std::uint64_t instructions = 0;
+            std::uint64_t cache_misses = 0;
+            std::uint64_t llc_loads = 0;
+            std::uint64_t llc_stores = 0;
+        };
+
+
+        // What happened in a single operator application
+        //
+
+        struct stage_record
+        {
+            std::type_index          op_type = typeid(void);  // dynamic type of the operator
+            std::size_t              stage = 0;               // position in the chain
+            std::chrono::nanoseconds elapsed = { };           // wall time
+            stage_shape              input = { };             // src on input
+            stage_shape              output = { };            // dst on output
+            bool                     reallocated = false;     // dst got a buffer neither dst nor src had
+            std::size_t              bytes = 0;               // bytes read and written
+            bool                     counted = false;         // counters holds the events of the stage, on every thread
+            stage_counters           counters = { };          // hardware events
+        };
+
+
+        // Interface for stage observers
+        //
+        // Observers are called from any thread applying operators, they must
+        // be thread safe.
+        //
+
+        class i_stage_observer
+        {
+        public:
+
+            virtual ~i_stage_observer() noexcept = default;
+
+            // Right before the operator is applied
+            //
+            virtual void stage_begin(i_operator const& op [[maybe_unused]], std::size_t const stage [[maybe_unused]])
+            {
+                // NOOP
+            }
+
+            // Right after the operator was applied
+            //
+            virtual void stage_end(stage_record const& record) = 0;
+
+            // Whether the stages should be measured with hardware counters,
+            // it is asked right before each stage
+            //
+            virtual bool counting() const noexcept
+            {
+                return false;
+            }
+
+        };
+
+
+        // Set the process wide stage observer, nullptr removes it. The caller
+        // keeps the ownership of the observer and must keep it alive while it
+        // is set.
+        //
+
+        void set_stage_observer(i_stage_observer* observer) noexcept;
+
+        i_stage_observer* get_stage_observer() noexcept;
+
+
+        // Stage observer that aggregates the records per operator type
+        //
+
+        class stage_profiler : public i_stage_observer
+        {
+        public:
+
+            // Wall time histogram, bucket k counts the stages that took less
+            // than 2^k nanoseconds, and at least 2^(k-1).
+            //
+            using histogram_t = std::array<std::uint64_t, 40>;
+
+            struct summary
+            {
+                std::type_index          op_type = typeid(void);
+                std::uint64_t            calls = 0;
+                std::uint64_t            reallocations = 0;
+                std::uint64_t            bytes = 0;
+                std::chrono::nanoseconds total = { };
+                std::chrono::nanoseconds min = std::chrono::nanoseconds::max();
+                std::chrono::nanoseconds max = { };
+                histogram_t              histogram = { };
+                std::uint64_t            counted = 0;     // calls with hardware counts
+                stage_counters           counters = { };  // hardware counts of those calls
+            };
+
+
+        public:
+
+            // With counting, the stages are also measured with hardware counters
+            //
+            explicit stage_profiler(bool const counting = false) noexcept;
+
+            virtual void stage_end(stage_record const& record) override;
+
+            virtual bool counting() const noexcept override;
+
+            // Summaries, one per operator type
+            //
+            std::vector<summary> report() const;
+
+            void reset();
+
+
+        private:
+
+            mutable std::mutex                     m_lock = { };
+
+            std::map<std::type_index, summary>     m_summaries = { };
+
+            bool                                   m_counting = false;
+
+        };
+
+    }
+
+}
+
+
+CVIP_BEGIN_IMPLEMENTATION_DETAILS(cvip::core)
+
+    // Read the hardware counters of the calling thread, false if they are
+    // not available
+    //
+
+    bool read_counters(stage_counters& counters) noexcept;
+
+
+    // Measures a single operator application, reporting it to the observer
+    //
+
+    class stage_probe
+    {
+    public:
+
+        stage_probe(i_operator const& op, std::size_t const stage, matrix const& dst, matrix const& src);
+
+        stage_probe(stage_probe const& src) = delete;
+
+        ~stage_probe() noexcept;
+
+        stage_probe& operator=(stage_probe const& src) = delete;
+
+        void finish(matrix const& dst);
+
+        // The probe counting the stage being applied by the calling thread,
+        // nullptr if none
+        //
+        static stage_probe* active() noexcept;
+
+
+    private:
+
+        friend class stripe_probe;
+
+        using clock_t = std::chrono::steady_clock;
+
+        void deactivate() noexcept;
+
+        void add_worker(bool const counted, stage_counters const& counters) noexcept;
+
+
+    private:
+
+        i_stage_observer*  m_observer;
+
+        i_operator const&  m_op;
+
+        std::size_t        m_stage;
+
+        stage_shape        m_input = { };
+
+        std::size_t        m_input_bytes = 0;
+
+        cv::UMatData const* m_dst_u = nullptr;  // buffers on start
+
+        cv::UMatData const* m_src_u = nullptr;
+
+        clock_t::time_point m_start = { };
+
+        bool               m_counting = false;
+
+        stage_counters     m_counters = { };  // on start
+
+        std::thread::id    m_thread = { };
+
+        stage_probe*       m_outer = nullptr;  // active before this one
+
+        bool               m_active = false;
+
+        std::mutex         m_workers_lock = { };
+
+        bool               m_workers_counted = true;
+
+        stage_counters     m_workers = { };  // counted on other threads
+
+    };
+
+
+    // Measures the share of a stage run by another thread, e.g. a stripe run
+    // by a cv::parallel_for_ worker, adding its hardware counts to the stage
+    // probe, or leaving the stage uncounted if they are not available there
+    //
+
+    class stripe_probe
+    {
+    public:
+
+        explicit stripe_probe(stage_probe* const stage) noexcept;
+
+        stripe_probe(stripe_probe const& src) = delete;
+
+        ~stripe_probe() noexcept;
+
+        stripe_probe& operator=(stripe_probe const& src) = delete;
+
+
+    private:
+
+        stage_probe*    m_stage = nullptr;
+
+        stage_counters  m_counters = { };  // on start
+
+    };
+
+CVIP_END_IMPLEMENTATION_DETAILS(cvip::core)
+
+
+// Instrumentation hooks
+//
+
+#if defined(CVIP_CONFIG_ENABLE_PROFILING)
+#   define CVIP_PROFILE_STAGE_BEGIN(op, stage, dst, src) \
+        auto cvip_stage_probe = ::cvip::core::detail::stage_probe{ op, stage, dst, src }
+#   define CVIP_PROFILE_STAGE_END(dst) \
+        cvip_stage_probe.finish(dst)
+#   define CVIP_PROFILE_STRIPES() \
+        auto const cvip_stripes_probe = ::cvip::core::detail::stage_probe::active()
+#   define CVIP_PROFILE_STRIPE() \
+        auto const cvip_stripe_probe = ::cvip::core::detail::stripe_probe{ cvip_stripes_probe }
+#else
+#   define CVIP_PROFILE_STAGE_BEGIN(op, stage, dst, src)
+#   define CVIP_PROFILE_STAGE_END(dst)
+#   define CVIP_PROFILE_STRIPES()
+#   define CVIP_PROFILE_STRIPE()
+#endif // defined(CVIP_CONFIG_ENABLE_PROFILING)
+
+
+#endif // !CVIP_CORE_PROFILING_HPP
@@ -0,0 +1,189 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_RESULT_CACHE_HPP
+#define CVIP_CORE_RESULT_CACHE_HPP
+
+#pragma once
+
+
+#include "internal/basic_types.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        // Expression result cache
+        //
+        // Memoizes the results of operator expressions, keyed by the
+        // fingerprint of the chain of operators (see operator_traits) and a
+        // 128-bit content hash of the input matrix. A repeated application
+        // of the same chain on the same input returns the cached result
+        // instead of recomputing it.
+        //
+        // The inputs are not kept, nor compared: two inputs with the same
+        // shape and content hash are taken as the same one. A lookup costs a
+        // pass over the input to hash it, and nothing else.
+        //
+        // The results are shared, not copied: the cache keeps the result it
+        // is given, and hands it out on a hit. They are read only, a result
+        // to be modified must be cloned first; the operators and expressions
+        // never overwrite them in place, see i_operator::apply.
+        //
+        // The capacity limits the number of bytes of the cached results, the
+        // least recently used entries are dropped to make room for new ones.
+        // A result larger than the capacity is not cached.
+        //
+        // All member functions are thread safe.
+        //
+
+        class result_cache
+        {
+        public:
+
+            // Cache usage statistics
+            //
+            struct statistics
+            {
+                std::size_t hits      = 0;  // lookups served from the cache
+                std::size_t misses    = 0;  // lookups not found in the cache
+                std::size_t evictions = 0;  // results dropped to honour the capacity
+                std::size_t entries   = 0;  // results currently held
+                std::size_t bytes     = 0;  // bytes currently held
+            };
+
+            // 128-bit content hash
+            //
+            using content_t = std::array<std::uint64_t, 2>;
+
+            // Cache key
+            //
+            struct key_t
+            {
+                std::size_t   chain   = 0;    // fingerprint of the chain of operators
+                content_t     content = { };  // content hash of the input
+                int           rows    = 0;
+                int           cols    = 0;
+                int           type    = 0;
+
+                bool operator==(key_t const& other) const noexcept;
+            };
+
+            static constexpr auto default_capacity = std::size_t{ 256 * 1024 * 1024 };
+
+
+        public:
+
+            explicit result_cache(std::size_t const capacity = default_capacity);
+
+            result_cache(result_cache const& src) = delete;
+
+            result_cache(result_cache&& src) = delete;
+
+            ~result_cache() noexcept = default;
+
+            result_cache& operator=(result_cache const& src) = delete;
+
+            result_cache& operator=(result_cache&& src) = delete;
+
+
+        public:
+
+            // Key of the result of a chain, with the given fingerprint, on a
+            // matrix
+            //
+            static key_t make_key(std::size_t const chain, matrix const& rhs_im);
+
+            // Content hash of a matrix, only its elements are hashed
+            //
+            static content_t content_hash(matrix const& mat) noexcept;
+
+            // The cached result with the given key, if any, read only
+            //
+            std::optional<matrix> find(key_t const& key);
+
+            // Cache the result with the given key, replacing any previous one;
+            // the result must not be modified afterwards
+            //
+            void insert(key_t const& key, matrix const& result);
+
+            // Drop every result
+            //
+            void clear();
+
+            // Capacity in bytes
+            //
+            std::size_t capacity() const noexcept;
+
+            // Usage statistics
+            //
+            statistics stats() const;
+
+
+        private:
+
+            struct key_hash_t
+            {
+                std::size_t operator()(key_t const& key) const noexcept;
+            };
+
+            struct entry_t
+            {
+                key_t  key;
+                matrix result;
+            };
+
+            using entries_t = std::list<entry_t>;
+            using index_t   = std::unordered_map<key_t, entries_t::iterator, key_hash_t>;
+
+
+        private:
+
+            static std::size_t bytes_of(matrix const& mat) noexcept;
+
+            void erase(entries_t::iterator entry);
+
+
+        private:
+
+            std::size_t const  m_capacity;
+
+            mutable std::mutex m_lock = { };
+
+            entries_t          m_entries = { };  // most recently used first
+
+            index_t            m_index = { };
+
+            statistics         m_stats = { };
+
+        };
+
+    }
+
+}
+
+
+#endif // !CVIP_CORE_RESULT_CACHE_HPP
@@ -0,0 +1,167 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_REWRITE_HPP
+#define CVIP_CORE_REWRITE_HPP
+
+#pragma once
+
+
+#include "i_operator.hpp"
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <type_traits>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    // Expression rewriting
+    //
+    // When asked to, see operator_expression::optimize, an expression
+    // rewrites its chain with algebraic rules, until no rule applies:
+    //
+    //  -   an operator that declares itself as an identity (see
+    //      operator_traits::identity) is dropped,
+    //
+    //  -   a unary rule registered for the type of an operator  may  replace
+    //      it with a chain of zero or more operators,
+    //
+    //  -   a binary rule registered for the types of two adjacent operators,
+    //      in application order, may replace both with a chain of  zero  or
+    //      more operators, e.g. to cancel an involutive pair or to fold two
+    //      affine intensity transforms into one.
+    //
+    // Rules match the dynamic type of the operators exactly, and must only
+    // produce equivalent chains. A rule declines to rewrite by returning an
+    // empty optional.
+    //
+    // A static_expression is rewritten as a single operator, the predicates
+    // in it are not.
+    //
+
+    namespace core
+    {
+
+        // Chain of operators, in application order
+        //
+        using operator_chain = std::vector<std::shared_ptr<i_operator>>;
+
+        // Result of a rewrite rule, empty if the rule does not apply
+        //
+        using rewrite_t = std::optional<operator_chain>;
+
+
+        // Rewrite to the given operators, in application order; with no
+        // operators, the rewritten operators are removed
+        //
+
+        template<typename ...Operators>
+        rewrite_t rewrite_as(Operators&& ...ops);
+
+
+        // Set of rewrite rules
+        //
+        // All member functions are thread safe.
+        //
+
+        class rewrite_rules
+        {
+        public:
+
+            using unary_rule_t  = std::function<rewrite_t(i_operator const& op)>;
+            using binary_rule_t = std::function<rewrite_t(i_operator const& first, i_operator const& second)>;
+
+
+        public:
+
+            // Process wide rules, used by operator_expression::optimize unless
+            // other rules are given
+            //
+            static rewrite_rules& global();
+
+            // Add a rule for an Operator, rule(Operator const&) -> rewrite_t
+            //
+            template<typename Operator, typename Rule,
+                     typename = std::enable_if_t<std::is_invocable_v<Rule&, Operator const&>>>
+            void add(Rule&& rule);
+
+            // Add a rule for a First operator applied right before a Second
+            // one, rule(First const&, Second const&) -> rewrite_t
+            //
+            template<typename First, typename Second, typename Rule>
+            void add(Rule&& rule);
+
+            // Remove every rule
+            //
+            void clear();
+
+            // Rewrite a single operator, or a pair of adjacent operators with
+            // the first rule that applies
+            //
+            rewrite_t rewrite(i_operator const& op) const;
+
+            rewrite_t rewrite(i_operator const& first, i_operator const& second) const;
+
+
+        private:
+
+            using pair_key_t = std::pair<std::type_index, std::type_index>;
+
+
+        private:
+
+            void add_unary(std::type_index const key, unary_rule_t&& rule);
+
+            void add_binary(pair_key_t const& key, binary_rule_t&& rule);
+
+
+        private:
+
+            mutable std::shared_mutex                            m_lock = { };
+
+            std::map<std::type_index, std::vector<unary_rule_t>> m_unary = { };
+
+            std::map<pair_key_t, std::vector<binary_rule_t>>     m_binary = { };
+
+        };
+
+
+        // Add a rule to the process wide rules
+        //
+
+        template<typename Operator, typename Rule,
+                 typename = std::enable_if_t<std::is_invocable_v<Rule&, Operator const&>>>
+        void add_rewrite_rule(Rule&& rule);
+
+        template<typename First, typename Second, typename Rule>
+        void add_rewrite_rule(Rule&& rule);
+
+    }
+
+}
+
+
+#include "internal/rewrite.inl"
+
+
+#endif // !CVIP_CORE_REWRITE_HPP
@@ -0,0 +1,151 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_SCHEDULER_HPP
+#define CVIP_CORE_SCHEDULER_HPP
+
+#pragma once
+
+
+#include "internal/basic_types.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        // Work-stealing task scheduler
+        //
+        // Runs tasks on a fixed set of worker threads. Each worker has its own
+        // queue: a task submitted from a worker goes to the back of its queue
+        // and the worker runs its newest task first, so that the results it
+        // just produced are still in its cache; an idle worker steals the
+        // oldest task from the queue of another one. Tasks submitted from
+        // other threads are spread among the queues.
+        //
+        // A thread waiting for some tasks to finish, see wait_until, runs
+        // queued tasks in the meantime, so that tasks may wait for the tasks
+        // they submit without exhausting the workers.
+        //
+        // Tasks must not throw. All member functions are thread safe.
+        //
+
+        class task_scheduler
+        {
+        public:
+
+            using task_t = std::function<void()>;
+
+
+        public:
+
+            // Each worker runs setup, if any, before it takes any task, e.g. to
+            // pin itself to some processors
+            //
+            explicit task_scheduler(std::size_t const workers = default_workers(), task_t setup = { });
+
+            task_scheduler(task_scheduler const& src) = delete;
+
+            task_scheduler(task_scheduler&& src) = delete;
+
+            // Waits for the queued tasks to finish
+            //
+            ~task_scheduler() noexcept;
+
+            task_scheduler& operator=(task_scheduler const& src) = delete;
+
+            task_scheduler& operator=(task_scheduler&& src) = delete;
+
+
+        public:
+
+            // Process wide scheduler, with a worker per hardware thread
+            //
+            static task_scheduler& global();
+
+            // One worker per hardware thread
+            //
+            static std::size_t default_workers() noexcept;
+
+            // Queue a task
+            //
+            void submit(task_t task);
+
+            // Run queued tasks in the calling thread until done() is true,
+            // done() is checked whenever a task finishes
+            //
+            void wait_until(std::function<bool()> const& done);
+
+            // Number of worker threads
+            //
+            std::size_t workers() const noexcept;
+
+
+        private:
+
+            struct queue_t
+            {
+                std::mutex         lock = { };
+                std::deque<task_t> tasks = { };
+            };
+
+
+        private:
+
+            std::size_t home_queue() const noexcept;
+
+            bool run_one(std::size_t const home);
+
+            void work(std::size_t const index);
+
+
+        private:
+
+            std::vector<std::unique_ptr<queue_t>> m_queues = { };
+
+            std::vector<std::thread> m_threads = { };
+
+            std::mutex m_idle_lock = { };
+
+            std::condition_variable m_idle = { };  // a task was queued, or one finished and someone waits
+
+            std::atomic<std::size_t> m_queued = 0;
+
+            std::atomic<std::size_t> m_waiters = 0;
+
+            mutable std::atomic<std::size_t> m_next = 0;  // queue for the next task from a non worker thread
+
+            bool m_stop = false;
+
+        };
+
+    }
+
+}
+
+
+#endif // !CVIP_CORE_SCHEDULER_HPP
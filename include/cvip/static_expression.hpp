@@ -0,0 +1,208 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#ifndef CVIP_CORE_STATIC_EXPRESSION_HPP
+#define CVIP_CORE_STATIC_EXPRESSION_HPP
+
+#pragma once
+
+
+#include "operator.hpp"
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+#if not defined(CVIP_CONFIG_LOADED)
+#error ERROR: Missing config.hpp
+#endif // defined(CVIP_CONFIG_LOADED)
+
+
+namespace cvip
+{
+
+    // Static operator expressions
+    //
+    // A product of predicate based image operators,  basic_operator<Predicate>,
+    // may be built as a static_expression, on request, with make_static, that
+    // holds a copy of each predicate in a std::tuple, in the order they  are
+    // going to be applied. Once there, multiplying by basic operators or by
+    // other static expressions extends it:
+    //
+    //      make_static(B2, B1) -> SX(B1, B2),
+    //      SX(B1, B2) * B3 -> SX(B3, B1, B2),
+    //      B3 * SX(B1, B2) -> SX(B1, B2, B3),
+    //      SX(B1, B2) * SX(B3, B4) -> SX(B3, B4, B1, B2).
+    //
+    // Products of basic operators are otherwise dynamic operator_expressions,
+    // as any other product of operators, with all their features, e.g. stage
+    // access, incremental evaluation, tiling, pooling or caching.
+    //
+    // The chain is known at compile time, so, applying a static expression on
+    // a matrix involves no cloning, no heap allocated list nodes and no virtual
+    // dispatch, and the compiler is free to inline the predicate bodies across
+    // stages.  Evaluation order and buffer  exchange  protocol are exactly the
+    // same as for operator_expression.
+    //
+    // When every predicate has an elementwise kernel for the depth  of  the
+    // image, the whole chain is fused into a single pass, as pointwise runs
+    // are in operator_expression.
+    //
+    // Each stage keeps the execution model of the operator it was taken from,
+    // so row separable stages are striped as basic_operator does.
+    //
+    // A static expression is an image operator by itself, so, whenever a non
+    // predicate based operator enters the product, the static expression  is
+    // gathered, as a single operator, into a dynamic operator_expression:
+    //
+    //      P3 * SX(B1, B2) -> EX(SX(B1, B2), P3).
+    //
+    // A static expression also converts implicitly into an  operator_expression
+    // with one stage per predicate, each one a basic_operator with the
+    // execution model of the operator it was taken from:
+    //
+    //      operator_expression f() { return make_static(B2, B1); }
+    //
+
+    namespace core
+    {
+
+        // Static operator expression
+        //
+        // Compile-time chain of operator predicates, Predicates... are listed
+        // in application order.
+        //
+
+        template<typename ...Predicates>
+        class static_expression : public base_operator< static_expression<Predicates...> >
+        {
+        public:
+
+            static_expression() = delete;
+
+            static_expression(static_expression const& src) = default;
+
+            static_expression(static_expression&& src) = default;
+
+            virtual ~static_expression() noexcept = default;
+
+            static_expression& operator=(static_expression const& src) = default;
+
+            static_expression& operator=(static_expression&& src) = default;
+
+
+        protected:
+
+            virtual void apply(matrix& dst, matrix& src, bool const first) override;
+
+            virtual operator_traits traits() const override;
+
+            virtual std::optional<matrix_shape> infer(matrix_shape const& input) const override;
+
+            virtual void map(void const* src, void* dst, int const count, int const depth) const override;
+
+
+        private:
+
+            using chain_t  = std::tuple<Predicates...>;
+            using models_t = std::array<execution_model, sizeof...(Predicates)>;
+
+            // depths for which every predicate has an elementwise kernel
+            //
+            static constexpr auto pointwise_depths = (detail::pointwise_depths<Predicates> & ...);
+
+            static_expression(chain_t&& chain, models_t const& models);
+
+
+        private:
+
+            matrix apply(matrix const& rhs_im);
+
+            matrix apply(matrix&& rhs_im);
+
+            template<std::size_t ...I>
+            void apply_chain(matrix& dst, matrix& src, bool const first, bool const owned, std::index_sequence<I...>);
+
+            void apply_fused(matrix& dst, matrix& src, bool const first);
+
+            template<typename T, std::size_t ...I>
+            void map_chain(T const* src, T* dst, int const count, std::index_sequence<I...>) const;
+
+            template<typename Predicate>
+            static std::tuple<Predicate> chain_of(basic_operator<Predicate> const& op);
+
+            template<typename Predicate>
+            static std::array<execution_model, 1> models_of(basic_operator<Predicate> const& op);
+
+            template<std::size_t N, std::size_t M>
+            static models_t join(std::array<execution_model, N> const& first,
+                                 std::array<execution_model, M> const& second);
+
+
+        private:
+
+            template<typename ...Other>
+            friend class static_expression;
+
+            friend class operator_expression;
+
+            template<typename Predicate>
+            friend static_expression<Predicate> make_static(basic_operator<Predicate> const& op);
+
+            template<typename ...Lhs, typename Rhs>
+            friend static_expression<Rhs, Lhs...> operator*(static_expression<Lhs...> const& lhs_ex,
+                                                            basic_operator<Rhs> const& rhs_op);
+
+            template<typename Lhs, typename ...Rhs>
+            friend static_expression<Rhs..., Lhs> operator*(basic_operator<Lhs> const& lhs_op,
+                                                            static_expression<Rhs...> const& rhs_ex);
+
+            template<typename ...Lhs, typename ...Rhs>
+            friend static_expression<Rhs..., Lhs...> operator*(static_expression<Lhs...> const& lhs_ex,
+                                                               static_expression<Rhs...> const& rhs_ex);
+
+            template<typename ...Other>
+            friend matrix operator*(static_expression<Other...>& lhs_ex, matrix const& rhs_im);
+
+            template<typename ...Other>
+            friend matrix operator*(static_expression<Other...>& lhs_ex, matrix&& rhs_im);
+
+
+        private:
+
+            chain_t m_chain;
+
+            models_t m_models;
+
+        };
+
+
+        // Static expression of a product of basic operators, listed as they
+        // appear in the product, i.e. make_static(B2, B1) stands for B2 * B1
+        //
+
+        template<typename Predicate>
+        static_expression<Predicate> make_static(basic_operator<Predicate> const& op);
+
+        template<typename First, typename Second, typename ...Rest>
+        auto make_static(basic_operator<First> const& first, basic_operator<Second> const& second,
+                         basic_operator<Rest> const& ...rest);
+
+    }
+
+}
+
+
+#include "internal/static_expression.inl"
+
+
+#endif // !CVIP_CORE_STATIC_EXPRESSION_HPP
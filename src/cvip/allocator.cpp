@@ -0,0 +1,395 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+
+#include <cvip/allocator.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+
+#if defined(CVIP_TARGET_POSIX_BUILD)
+#include <sys/mman.h>
+#elif defined(CVIP_TARGET_WINDOWS_BUILD)
+#include <malloc.h>
+#endif // defined(CVIP_TARGET_POSIX_BUILD)
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        namespace
+        {
+
+            // The allocator in scope in the calling thread, and whether it
+            // allocates the results too
+            //
+
+            thread_local matrix_allocator* current_allocator = nullptr;
+            thread_local bool              current_results   = true;
+
+        }
+
+
+        // matrix_allocator::pool_t
+        //
+        // The state of an allocator, each matrix allocated from the pool
+        // holds a reference to it in its UMatData::userdata, so that the
+        // pool is released with the last of the allocator and the matrices.
+        //
+
+        class matrix_allocator::pool_t : public cv::MatAllocator, public std::enable_shared_from_this<pool_t>
+        {
+        public:
+
+            using owner_t = std::shared_ptr<pool_t const>;
+
+
+        public:
+
+            pool_t(bool const huge_pages, std::size_t const capacity) noexcept :
+                m_huge_pages{ huge_pages },
+                m_capacity{ capacity }
+            {
+                // NOOP
+            }
+
+            virtual ~pool_t() noexcept
+            {
+                for (auto const& block : m_blocks)
+                {
+                    release(block.second);
+                }
+            }
+
+
+        public:
+
+            void clear()
+            {
+                auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+                for (auto const& block : m_blocks)
+                {
+                    release(block.second);
+                }
+
+                m_stats.blocks -= m_blocks.size();
+                m_stats.pooled  = 0;
+
+                m_blocks.clear();
+            }
+
+            bool huge_pages() const noexcept
+            {
+                return m_huge_pages;
+            }
+
+            std::size_t capacity() const noexcept
+            {
+                return m_capacity;
+            }
+
+            statistics stats() const
+            {
+                auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+                return m_stats;
+            }
+
+
+        public:
+
+            virtual cv::UMatData* allocate(int const dims, int const* const sizes, int const type,
+                                           void* const data, std::size_t* const step,
+                                           cv::AccessFlag const flags, cv::UMatUsageFlags const usage) const override
+            {
+                if (data != nullptr)
+                {
+                    return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage);
+                }
+
+                auto total = static_cast<std::size_t>(CV_ELEM_SIZE(type));
+
+                for (auto k = dims; k-- > 0; )
+                {
+                    if (step != nullptr)
+                    {
+                        step[k] = total;
+                    }
+
+                    total *= static_cast<std::size_t>(sizes[k]);
+                }
+
+                auto const size = block_size(total);
+
+                auto u     = std::make_unique<cv::UMatData>(this);
+                auto owner = std::make_unique<owner_t>(shared_from_this());
+                auto block = static_cast<void*>(nullptr);
+
+                {
+                    auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+                    auto const found = m_blocks.find(size);
+
+                    if (found != m_blocks.end())
+                    {
+                        block = found->second;
+
+                        m_blocks.erase(found);
+
+                        m_stats.pooled -= size;
+
+                        ++m_stats.reuses;
+                    }
+                }
+
+                if (block == nullptr)
+                {
+                    block = obtain(size);
+                }
+
+                {
+                    auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+                    ++m_stats.allocations;
+
+                    m_stats.bytes += size;
+                    m_stats.peak   = std::max(m_stats.peak, m_stats.bytes);
+                }
+
+                u->data = u->origdata = static_cast<upix_t*>(block);
+                u->size = total;
+
+                u->userdata = owner.release();
+
+                return u.release();
+            }
+
+            virtual bool allocate(cv::UMatData* const data, cv::AccessFlag const flags [[maybe_unused]],
+                                  cv::UMatUsageFlags const usage [[maybe_unused]]) const override
+            {
+                return data != nullptr;
+            }
+
+            virtual void deallocate(cv::UMatData* const data) const override
+            {
+                if (data == nullptr)
+                {
+                    return;
+                }
+
+                // REMARK: The reference to the pool is dropped last, it may
+                //         be the last one, destroying the pool on return.
+
+                auto const owner = std::unique_ptr<owner_t>{ static_cast<owner_t*>(data->userdata) };
+
+                auto const size  = block_size(data->size);
+                auto const block = static_cast<void*>(data->origdata);
+
+                delete data;
+
+                {
+                    auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+                    m_stats.bytes -= size;
+
+                    if (m_stats.pooled + size <= m_capacity)
+                    {
+                        m_blocks.emplace(size, block);
+
+                        m_stats.pooled += size;
+
+                        return;
+                    }
+
+                    --m_stats.blocks;
+                }
+
+                release(block);
+            }
+
+
+        private:
+
+            using blocks_t = std::multimap<std::size_t, void*>;  // by size
+
+
+        private:
+
+            std::size_t block_size(std::size_t const bytes) const noexcept
+            {
+                // REMARK: Sizes are rounded up so that blocks of close sizes, e.g.
+                //         frames of a few more rows, are reused for each other.
+
+                auto const unit = m_huge_pages and bytes >= huge_page_size ? huge_page_size : alignment;
+
+                return std::max((bytes + unit - 1) / unit, std::size_t{ 1 }) * unit;
+            }
+
+            void* obtain(std::size_t const size) const
+            {
+                auto const huge = m_huge_pages and size >= huge_page_size;
+
+                auto block = static_cast<void*>(nullptr);
+
+#if defined(CVIP_TARGET_WINDOWS_BUILD)
+                block = ::_aligned_malloc(size, huge ? huge_page_size : alignment);
+#else
+                if (::posix_memalign(&block, huge ? huge_page_size : alignment, size) != 0)
+                {
+                    block = nullptr;
+                }
+#endif // defined(CVIP_TARGET_WINDOWS_BUILD)
+
+                if (block == nullptr)
+                {
+                    throw std::bad_alloc{ };
+                }
+
+#if defined(MADV_HUGEPAGE)
+                // REMARK: It is a hint, the block is usable anyway.
+
+                if (huge)
+                {
+                    ::madvise(block, size, MADV_HUGEPAGE);
+                }
+#endif // defined(MADV_HUGEPAGE)
+
+                auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+                ++m_stats.blocks;
+
+                return block;
+            }
+
+            static void release(void* const block) noexcept
+            {
+#if defined(CVIP_TARGET_WINDOWS_BUILD)
+                ::_aligned_free(block);
+#else
+                std::free(block);
+#endif // defined(CVIP_TARGET_WINDOWS_BUILD)
+            }
+
+
+        private:
+
+            bool const m_huge_pages;
+
+            std::size_t const m_capacity;
+
+            mutable std::mutex m_lock = { };
+
+            mutable blocks_t m_blocks = { };  // kept for reuse
+
+            mutable statistics m_stats = { };
+
+        };
+
+
+        // matrix_allocator
+        //
+
+        matrix_allocator::matrix_allocator(bool const huge_pages, std::size_t const capacity) :
+            m_pool{ std::make_shared<pool_t>(huge_pages, capacity) }
+        {
+            // NOOP
+        }
+
+        matrix_allocator::~matrix_allocator() noexcept
+        {
+            // NOOP
+        }
+
+        matrix_allocator* matrix_allocator::current() noexcept
+        {
+            return current_allocator;
+        }
+
+        matrix_allocator* matrix_allocator::current_for_results() noexcept
+        {
+            return current_results ? current_allocator : nullptr;
+        }
+
+        void matrix_allocator::clear()
+        {
+            m_pool->clear();
+        }
+
+        bool matrix_allocator::huge_pages() const noexcept
+        {
+            return m_pool->huge_pages();
+        }
+
+        std::size_t matrix_allocator::capacity() const noexcept
+        {
+            return m_pool->capacity();
+        }
+
+        matrix_allocator::statistics matrix_allocator::stats() const
+        {
+            return m_pool->stats();
+        }
+
+        bool matrix_allocator::owns(matrix const& mat) const noexcept
+        {
+            return mat.u != nullptr and mat.u->currAllocator == m_pool.get();
+        }
+
+        cv::UMatData* matrix_allocator::allocate(int const dims, int const* const sizes, int const type,
+                                                 void* const data, std::size_t* const step,
+                                                 cv::AccessFlag const flags, cv::UMatUsageFlags const usage) const
+        {
+            // REMARK: The matrices are handed to the pool, they may outlive
+            //         the allocator.
+
+            return m_pool->allocate(dims, sizes, type, data, step, flags, usage);
+        }
+
+        bool matrix_allocator::allocate(cv::UMatData* const data, cv::AccessFlag const flags,
+                                        cv::UMatUsageFlags const usage) const
+        {
+            return m_pool->allocate(data, flags, usage);
+        }
+
+        void matrix_allocator::deallocate(cv::UMatData* const data) const
+        {
+            m_pool->deallocate(data);
+        }
+
+
+        // allocator_scope
+        //
+
+        allocator_scope::allocator_scope(matrix_allocator* const allocator, bool const results) noexcept :
+            m_previous{ current_allocator },
+            m_previous_results{ current_results }
+        {
+            current_allocator = allocator;
+            current_results   = results;
+        }
+
+        allocator_scope::~allocator_scope() noexcept
+        {
+            current_allocator = m_previous;
+            current_results   = m_previous_results;
+        }
+
+    }
+
+}
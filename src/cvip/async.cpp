@@ -0,0 +1,211 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+
+#include <cvip/async.hpp>
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        // cancel_token
+        //
+
+        cancel_token::cancel_token() :
+            m_flag{ std::make_shared<std::atomic<bool>>(false) }
+        {
+            // NOOP
+        }
+
+        void cancel_token::cancel() noexcept
+        {
+            *m_flag = true;
+        }
+
+        bool cancel_token::cancelled() const noexcept
+        {
+            return *m_flag;
+        }
+
+
+        // async_executor
+        //
+
+        async_executor::async_executor(std::size_t const workers, std::size_t const capacity,
+                                       std::shared_ptr<matrix_allocator> allocator) :
+            m_capacity{ capacity > 0 ? capacity : 4 * std::max<std::size_t>(workers, 1) },
+            m_allocator{ std::move(allocator) },
+            m_scheduler{ workers }
+        {
+            // NOOP
+        }
+
+        async_executor& async_executor::global()
+        {
+            static auto executor = async_executor{ };
+
+            return executor;
+        }
+
+        std::future<matrix> async_executor::submit(work_t work, cancel_token const& token)
+        {
+            {
+                auto lock = std::unique_lock<std::mutex>{ m_lock };
+
+                m_room.wait(lock, [this]() { return m_in_flight < m_capacity; });
+
+                ++m_in_flight;
+            }
+
+            return enqueue(std::move(work), token);
+        }
+
+        std::future<matrix> async_executor::try_submit(work_t work, cancel_token const& token)
+        {
+            {
+                auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+                if (m_in_flight >= m_capacity)
+                {
+                    return { };
+                }
+
+                ++m_in_flight;
+            }
+
+            return enqueue(std::move(work), token);
+        }
+
+        std::size_t async_executor::capacity() const noexcept
+        {
+            return m_capacity;
+        }
+
+        std::size_t async_executor::in_flight() const
+        {
+            auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+            return m_in_flight;
+        }
+
+        std::future<matrix> async_executor::enqueue(work_t work, cancel_token const& token)
+        {
+            // REMARK: The slot taken by the caller is given back if the work
+            //         can not be queued.
+
+            try
+            {
+                auto promise = std::make_shared<std::promise<matrix>>();
+
+                auto future = promise->get_future();
+
+                m_scheduler.submit([this, promise, work = std::move(work), token]()
+                {
+                    auto result = matrix{ };
+                    auto error  = std::exception_ptr{ };
+
+                    if (token.cancelled())
+                    {
+                        error = std::make_exception_ptr(cancelled_error{ });
+                    }
+                    else
+                    {
+                        try
+                        {
+                            auto const scope = allocator_scope{ m_allocator.get() };
+
+                            result = work();
+                        }
+                        catch (...)
+                        {
+                            error = std::current_exception();
+                        }
+                    }
+
+                    // REMARK: Make room before the result is ready, so that
+                    //         a caller waiting for it can submit right away.
+
+                    release();
+
+                    if (error)
+                    {
+                        promise->set_exception(error);
+                    }
+                    else
+                    {
+                        promise->set_value(std::move(result));
+                    }
+                });
+
+                return future;
+            }
+            catch (...)
+            {
+                release();
+
+                throw;
+            }
+        }
+
+        void async_executor::release() noexcept
+        {
+            {
+                auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+                --m_in_flight;
+            }
+
+            m_room.notify_one();
+        }
+
+
+        // apply_async
+        //
+
+        std::future<matrix> apply_async(i_operator const& op, matrix rhs_im, cancel_token const& token,
+                                        async_executor& executor)
+        {
+            return executor.submit([node = op.clone(), rhs_im = std::move(rhs_im)]() mutable
+            {
+                return *node * std::move(rhs_im);
+            }, token);
+        }
+
+        std::future<matrix> apply_async(operator_expression const& ex, matrix rhs_im, cancel_token const& token,
+                                        async_executor& executor)
+        {
+            auto clone = std::make_shared<operator_expression>(ex.clone());
+
+            return executor.submit([clone, rhs_im = std::move(rhs_im)]() mutable
+            {
+                return *clone * std::move(rhs_im);
+            }, token);
+        }
+
+        std::future<matrix> apply_async(frozen_expression const& ex, matrix rhs_im, cancel_token const& token,
+                                        async_executor& executor)
+        {
+            return executor.submit([ex, rhs_im = std::move(rhs_im)]() mutable
+            {
+                return ex * std::move(rhs_im);
+            }, token);
+        }
+
+    }
+
+}
@@ -0,0 +1,216 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#include <cvip/allocator.hpp>
+#include <cvip/batch.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        namespace
+        {
+
+            // The result of a frame, copied out of the pool of the allocator
+            // in scope only if it ended there, e.g. when the last operator
+            // worked in place on an intermediate result
+            //
+
+            matrix detached(matrix&& result)
+            {
+                auto const* const allocator = matrix_allocator::current();
+
+                return allocator != nullptr and allocator->owns(result) ? result.clone() : std::move(result);
+            }
+
+            // Distributes the input matrices among the workers, make_worker
+            // is called once per worker thread and must return a callable
+            // that applies its own operator state on a matrix.
+            //
+
+            template<typename MakeWorker>
+            std::vector<matrix> run_batch(std::vector<matrix> const& rhs_ims, execution_model const model,
+                                          MakeWorker const& make_worker)
+            {
+                auto result = std::vector<matrix>(rhs_ims.size());
+
+                if (model == execution_model::sequential or rhs_ims.size() < 2)
+                {
+                    auto worker = make_worker();
+
+                    for (auto i = std::size_t{ 0 }; i < rhs_ims.size(); ++i)
+                    {
+                        result[i] = worker(rhs_ims[i]);
+                    }
+
+                    return result;
+                }
+
+                auto const hardware = std::max(std::thread::hardware_concurrency(), 1u);
+                auto const workers  = std::min<std::size_t>(hardware, rhs_ims.size());
+
+                auto next       = std::atomic<std::size_t>{ 0 };
+                auto error      = std::exception_ptr{ };
+                auto error_lock = std::mutex{ };
+
+                auto const stop = [&next, &rhs_ims]()
+                {
+                    next = rhs_ims.size();
+                };
+
+                auto const work = [&]()
+                {
+                    try
+                    {
+                        auto worker = make_worker();
+
+                        for (auto i = next++; i < rhs_ims.size(); i = next++)
+                        {
+                            result[i] = worker(rhs_ims[i]);
+                        }
+                    }
+                    catch (...)
+                    {
+                        auto const lock = std::lock_guard<std::mutex>{ error_lock };
+
+                        if (not error)
+                        {
+                            error = std::current_exception();
+                        }
+
+                        stop();
+                    }
+                };
+
+                // REMARK: The calling thread is one of the workers.
+
+                auto threads = std::vector<std::thread>{ };
+
+                threads.reserve(workers - 1);
+
+                try
+                {
+                    for (auto k = std::size_t{ 1 }; k < workers; ++k)
+                    {
+                        threads.emplace_back(work);
+                    }
+                }
+                catch (...)
+                {
+                    stop();
+
+                    for (auto& thread : threads)
+                    {
+                        thread.join();
+                    }
+
+                    throw;
+                }
+
+                work();
+
+                for (auto& thread : threads)
+                {
+                    thread.join();
+                }
+
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+
+                return result;
+            }
+
+        }
+
+
+        std::vector<matrix> batch_apply(i_operator const& op, std::vector<matrix> const& rhs_ims,
+                                        execution_model const model)
+        {
+            auto const make_worker = [&op]()
+            {
+                return [node = op.clone()](matrix const& rhs_im)
+                {
+                    return *node * rhs_im;
+                };
+            };
+
+            return run_batch(rhs_ims, model, make_worker);
+        }
+
+        std::vector<matrix> batch_apply(operator_expression const& ex, std::vector<matrix> const& rhs_ims,
+                                        execution_model const model)
+        {
+            auto const make_worker = [&ex]()
+            {
+                return [clone = ex.clone()](matrix const& rhs_im) mutable
+                {
+                    return clone.apply(rhs_im);
+                };
+            };
+
+            return run_batch(rhs_ims, model, make_worker);
+        }
+
+
+        std::vector<matrix> batch_apply(i_operator const& op, std::vector<matrix> const& rhs_ims,
+                                        numa_scheduler& scheduler)
+        {
+            auto result = std::vector<matrix>(rhs_ims.size());
+
+            auto const make_worker = [&op, &rhs_ims, &result]() -> numa_scheduler::worker_t
+            {
+                return [node = op.clone(), &rhs_ims, &result](std::size_t const i)
+                {
+                    result[i] = detached(*node * rhs_ims[i]);
+                };
+            };
+
+            scheduler.run(rhs_ims.size(), make_worker);
+
+            return result;
+        }
+
+        std::vector<matrix> batch_apply(operator_expression const& ex, std::vector<matrix> const& rhs_ims,
+                                        numa_scheduler& scheduler)
+        {
+            auto result = std::vector<matrix>(rhs_ims.size());
+
+            auto const make_worker = [&ex, &rhs_ims, &result]() -> numa_scheduler::worker_t
+            {
+                auto clone = std::make_shared<operator_expression>(ex.clone());
+
+                return [clone, &rhs_ims, &result](std::size_t const i)
+                {
+                    result[i] = detached(clone->apply(rhs_ims[i]));
+                };
+            };
+
+            scheduler.run(rhs_ims.size(), make_worker);
+
+            return result;
+        }
+
+    }
+
+}
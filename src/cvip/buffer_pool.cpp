@@ -0,0 +1,127 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#include <cvip/buffer_pool.hpp>
+#include <cvip/internal/ownership.hpp>
+#include <algorithm>
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        buffer_pool::buffer_pool(std::size_t const capacity) :
+            m_capacity{ capacity }
+        {
+            // NOOP
+        }
+
+        matrix buffer_pool::acquire(int const rows, int const cols, int const type)
+        {
+            auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+            for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+            {
+                if (it->rows == rows and it->cols == cols and it->type == type and available(it->buffer))
+                {
+                    m_entries.splice(m_entries.begin(), m_entries, it);
+
+                    ++m_stats.hits;
+
+                    return m_entries.front().buffer;
+                }
+            }
+
+            ++m_stats.misses;
+
+            auto buffer = matrix(rows, cols, type);
+            auto const bytes = bytes_of(buffer);
+
+            if (bytes <= m_capacity)
+            {
+                evict(bytes);
+            }
+
+            if (m_stats.bytes + bytes <= m_capacity)
+            {
+                m_entries.push_front({ rows, cols, type, buffer });
+
+                m_stats.buffers += 1;
+                m_stats.bytes   += bytes;
+                m_stats.peak     = std::max(m_stats.peak, m_stats.bytes);
+            }
+
+            return buffer;
+        }
+
+        void buffer_pool::clear()
+        {
+            auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+            evict(unlimited);
+        }
+
+        std::size_t buffer_pool::capacity() const noexcept
+        {
+            return m_capacity;
+        }
+
+        buffer_pool::statistics buffer_pool::stats() const
+        {
+            auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+            return m_stats;
+        }
+
+        inline bool buffer_pool::available(matrix const& buffer) noexcept
+        {
+            // REMARK: Only the pool holds a reference to the buffer; the
+            //         holders of the others may drop them from any thread.
+
+            return detail::unshared(buffer);
+        }
+
+        inline std::size_t buffer_pool::bytes_of(matrix const& buffer) noexcept
+        {
+            return buffer.total() * buffer.elemSize();
+        }
+
+        void buffer_pool::evict(std::size_t const required)
+        {
+            // Drop available buffers, least recently used first, until the
+            // required number of bytes fits in the capacity. All available
+            // buffers are dropped when unlimited bytes are required.
+
+            auto it = m_entries.end();
+
+            while (it != m_entries.begin() and
+                   (required == unlimited or m_stats.bytes + required > m_capacity))
+            {
+                --it;
+
+                if (available(it->buffer))
+                {
+                    m_stats.buffers -= 1;
+                    m_stats.bytes   -= bytes_of(it->buffer);
+
+                    ++m_stats.evictions;
+
+                    it = m_entries.erase(it);
+                }
+            }
+        }
+
+    }
+
+}
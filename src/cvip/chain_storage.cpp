@@ -0,0 +1,279 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#include <cvip/internal/chain_storage.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <utility>
+
+
+CVIP_BEGIN_IMPLEMENTATION_DETAILS(cvip::core)
+
+    namespace
+    {
+
+        // The table of pointers follows the block header, aligned as the
+        // operators, which follow the table.
+        //
+
+        static auto constexpr alignment = alignof(std::max_align_t);
+
+        constexpr std::size_t align_up(std::size_t const bytes) noexcept
+        {
+            return (bytes + alignment - 1) / alignment * alignment;
+        }
+
+    }
+
+
+    // chain_storage
+    //
+
+    chain_storage::chain_storage(chain_storage const& src) noexcept :
+        m_block{ src.m_block }
+    {
+        if (m_block != nullptr)
+        {
+            m_block->references.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    chain_storage::chain_storage(chain_storage&& src) noexcept :
+        m_block{ std::exchange(src.m_block, nullptr) }
+    {
+        // NOOP
+    }
+
+    chain_storage::~chain_storage() noexcept
+    {
+        release(m_block);
+    }
+
+    chain_storage& chain_storage::operator=(chain_storage const& src) noexcept
+    {
+        if (src.m_block != nullptr)
+        {
+            src.m_block->references.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        release(m_block);
+
+        m_block = src.m_block;
+
+        return *this;
+    }
+
+    chain_storage& chain_storage::operator=(chain_storage&& src) noexcept
+    {
+        if (this != &src)
+        {
+            release(m_block);
+
+            m_block = std::exchange(src.m_block, nullptr);
+        }
+
+        return *this;
+    }
+
+    std::size_t chain_storage::size() const noexcept
+    {
+        return m_block != nullptr ? m_block->size : 0;
+    }
+
+    bool chain_storage::empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    chain_storage::iterator chain_storage::begin() const noexcept
+    {
+        return m_block != nullptr ? m_block->table() : nullptr;
+    }
+
+    chain_storage::iterator chain_storage::end() const noexcept
+    {
+        return m_block != nullptr ? m_block->table() + m_block->size : nullptr;
+    }
+
+    i_operator* chain_storage::operator[](std::size_t const index) const noexcept
+    {
+        return m_block->table()[index];
+    }
+
+    void chain_storage::insert(std::size_t const position, i_operator const& op)
+    {
+        reserve(op);
+
+        auto* const placed = place(*m_block, op);
+        auto* const table  = m_block->table();
+
+        std::move_backward(table + position, table + m_block->size, table + m_block->size + 1);
+
+        table[position] = placed;
+
+        ++m_block->size;
+    }
+
+    void chain_storage::push_back(i_operator const& op)
+    {
+        insert(size(), op);
+    }
+
+    i_operator& chain_storage::writable(std::size_t const index)
+    {
+        detach();
+
+        return *m_block->table()[index];
+    }
+
+    bool chain_storage::detach()
+    {
+        if (m_block == nullptr or m_block->references.load(std::memory_order_acquire) == 1)
+        {
+            return false;
+        }
+
+        copy_into(m_block->capacity, m_block->room);
+
+        return true;
+    }
+
+    void chain_storage::clear() noexcept
+    {
+        release(std::exchange(m_block, nullptr));
+    }
+
+    chain_storage::block_t* chain_storage::allocate(std::size_t const capacity, std::size_t const room)
+    {
+        auto const table_bytes = align_up(capacity * sizeof(i_operator*));
+
+        auto* const memory = ::operator new(align_up(sizeof(block_t)) + table_bytes + room);
+
+        auto* const block = ::new (memory) block_t{ };
+
+        block->capacity = capacity;
+        block->room     = room;
+
+        return block;
+    }
+
+    void chain_storage::release(block_t* const block) noexcept
+    {
+        if (block == nullptr or block->references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+
+        // REMARK: The operators cloned on the heap are released with the
+        //         spilled list, those in the block are destroyed in place.
+
+        auto* const first = block->storage();
+        auto* const last  = first + block->room;
+
+        for (auto k = std::size_t{ 0 }; k < block->size; ++k)
+        {
+            auto* const op = block->table()[k];
+            auto* const at = reinterpret_cast<unsigned char*>(op);
+
+            if (std::less_equal<unsigned char*>{ }(first, at) and std::less<unsigned char*>{ }(at, last))
+            {
+                op->~i_operator();
+            }
+        }
+
+        block->~block_t();
+
+        ::operator delete(block);
+    }
+
+    i_operator* chain_storage::place(block_t& block, i_operator const& op)
+    {
+        auto const bytes  = op.footprint();
+        auto const offset = align_up(block.used);
+
+        if (bytes > 0 and offset + bytes <= block.room)
+        {
+            auto* const placed = op.clone_into(block.storage() + offset);
+
+            block.used = offset + bytes;
+
+            return placed;
+        }
+
+        block.spilled.push_back(op.clone());
+
+        return block.spilled.back().get();
+    }
+
+    void chain_storage::reserve(i_operator const& op)
+    {
+        if (m_block == nullptr)
+        {
+            m_block = allocate(default_capacity, default_room);
+
+            return;
+        }
+
+        // REMARK: Operators larger than a whole default block are cloned on
+        //         the heap rather than growing the block for them.
+
+        auto const bytes = op.footprint();
+        auto const fits  = bytes == 0 or bytes > default_room or align_up(m_block->used) + bytes <= m_block->room;
+        auto const full  = m_block->size == m_block->capacity;
+
+        if (full or not fits or m_block->references.load(std::memory_order_acquire) != 1)
+        {
+            copy_into(full ? 2 * m_block->capacity : m_block->capacity,
+                      fits ? m_block->room : 2 * m_block->room + bytes);
+        }
+    }
+
+    void chain_storage::copy_into(std::size_t const capacity, std::size_t const room)
+    {
+        auto* const block = allocate(capacity, room);
+
+        try
+        {
+            for (auto const* op : *this)
+            {
+                block->table()[block->size] = place(*block, *op);
+
+                ++block->size;
+            }
+        }
+        catch (...)
+        {
+            release(block);
+
+            throw;
+        }
+
+        release(std::exchange(m_block, block));
+    }
+
+
+    // chain_storage::block_t
+    //
+
+    i_operator** chain_storage::block_t::table() noexcept
+    {
+        return reinterpret_cast<i_operator**>(reinterpret_cast<unsigned char*>(this) + align_up(sizeof(block_t)));
+    }
+
+    unsigned char* chain_storage::block_t::storage() noexcept
+    {
+        return reinterpret_cast<unsigned char*>(table()) + align_up(capacity * sizeof(i_operator*));
+    }
+
+CVIP_END_IMPLEMENTATION_DETAILS(cvip::core)
@@ -0,0 +1,348 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+
+#include <cvip/execution_plan.hpp>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/internal/ownership.hpp>
+#include <cvip/profiling.hpp>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        execution_plan::execution_plan(opchain_t const& chain, matrix_shape const& input, int const tile_side,
+                                       int const halo) :
+            m_chain{ chain },
+            m_input{ input }
+        {
+            if (input.rows <= 0 or input.cols <= 0)
+            {
+                throw std::invalid_argument("execution_plan: the input must not be empty");
+            }
+
+            if (tile_side == 0)
+            {
+                build(input);
+            }
+            else
+            {
+                // REMARK: Tiles on the borders of the image are smaller, or
+                //         grown less, there are a few distinct tile shapes.
+
+                auto const bounds = rect{ 0, 0, input.cols, input.rows };
+
+                for (auto y = 0; y < input.rows; y += tile_side)
+                {
+                    for (auto x = 0; x < input.cols; x += tile_side)
+                    {
+                        auto const tile = rect{ x, y, tile_side, tile_side } & bounds;
+                        auto const area = rect{ x - halo, y - halo, tile_side + 2 * halo, tile_side + 2 * halo } & bounds;
+
+                        auto const same = [&area](matrix_shape const& shape)
+                        {
+                            return shape.rows == area.height and shape.cols == area.width;
+                        };
+
+                        auto const found = std::find_if(m_areas.begin(), m_areas.end(), same);
+
+                        auto const program = found != m_areas.end()
+                            ? static_cast<std::size_t>(std::distance(m_areas.begin(), found))
+                            : build({ area.height, area.width, input.type });
+
+                        m_tiles.push_back({ tile, area, program });
+                    }
+                }
+            }
+
+            m_scratch.reserve(m_bytes, matrix_allocator::current());
+        }
+
+        matrix_shape const& execution_plan::input() const noexcept
+        {
+            return m_input;
+        }
+
+        std::size_t execution_plan::steps() const noexcept
+        {
+            return m_programs.empty() ? 0 : m_programs.front().size();
+        }
+
+        std::size_t execution_plan::tiles() const noexcept
+        {
+            return std::max<std::size_t>(m_tiles.size(), 1);
+        }
+
+        matrix operator*(execution_plan& lhs_plan, matrix const& rhs_im)
+        {
+            return lhs_plan.apply(matrix{ rhs_im });
+        }
+
+        matrix operator*(execution_plan& lhs_plan, matrix&& rhs_im)
+        {
+            return lhs_plan.apply(std::move(rhs_im));
+        }
+
+        std::size_t execution_plan::build(matrix_shape const& area)
+        {
+            // Group the operators into steps as apply_chain would do on an
+            // input of the given shape, and size the scratch buffers for the
+            // intermediate results of known shape.
+
+            auto program = program_t{ };
+            auto shape   = std::optional<matrix_shape>{ area };
+
+            for (auto k = std::size_t{ 0 }; k < m_chain.size(); )
+            {
+                auto step = step_t{ };
+
+                step.first = k;
+
+                // REMARK: Without the shape, the depth the pointwise runs
+                //         depend on is unknown, the rest of the chain is
+                //         grouped when applied.
+
+                if (not shape)
+                {
+                    step.count    = m_chain.size() - k;
+                    step.resolved = false;
+
+                    program.push_back(step);
+
+                    break;
+                }
+
+                auto const depth = CV_MAT_DEPTH(shape->type);
+
+                auto end = k;
+
+                while (end < m_chain.size() and (m_chain[end]->traits().pointwise & (1u << depth)) != 0u)
+                {
+                    ++end;
+                }
+
+                step.count    = std::max<std::size_t>(end - k, 1);
+                step.in_place = step.count > 1 or m_chain[k]->traits().in_place;
+
+                for (auto i = k; i < k + step.count; ++i)
+                {
+                    shape = shape ? m_chain[i]->infer(*shape) : std::nullopt;
+                }
+
+                step.shape   = shape;
+                step.scratch = shape and k + step.count < m_chain.size();
+
+                if (step.scratch)
+                {
+                    auto const elem_size = static_cast<std::size_t>(CV_ELEM_SIZE(shape->type));
+
+                    m_bytes = std::max(m_bytes, static_cast<std::size_t>(shape->rows) * shape->cols * elem_size);
+                }
+
+                program.push_back(step);
+
+                k += step.count;
+            }
+
+            m_programs.push_back(std::move(program));
+            m_areas.push_back(area);
+
+            return m_programs.size() - 1;
+        }
+
+        matrix execution_plan::apply(matrix&& rhs_im)
+        {
+            if (rhs_im.rows != m_input.rows or rhs_im.cols != m_input.cols or rhs_im.type() != m_input.type)
+            {
+                throw std::invalid_argument("execution_plan: the image does not match the plan");
+            }
+
+            if (m_chain.empty())
+            {
+                return detail::unshared(rhs_im) ? std::move(rhs_im) : rhs_im.clone();
+            }
+
+            // REMARK: Copies of a plan do not share the scratch buffers, a
+            //         copy allocates its own on its first application.
+
+            m_scratch.reserve(m_bytes, matrix_allocator::current());
+
+            if (m_tiles.empty())
+            {
+                auto src = matrix{ std::move(rhs_im) };
+                auto dst = matrix{ };
+
+                run(m_programs.front(), dst, src, detail::unshared(src), matrix_allocator::current_for_results());
+
+                // REMARK: The result is in src due to the swap
+                //         at the end of each iteration!
+
+                return src;
+            }
+
+            auto result = matrix{ };
+
+            for (auto const& tile : m_tiles)
+            {
+                auto src = rhs_im(tile.area);
+                auto dst = matrix{ };
+
+                run(m_programs[tile.program], dst, src, false, matrix_allocator::current());
+
+                if (result.empty())
+                {
+                    result.allocator = matrix_allocator::current_for_results();
+                    result.create(m_input.rows, m_input.cols, src.type());
+                    result.allocator = nullptr;
+                }
+
+                if (src.rows != tile.area.height or src.cols != tile.area.width or src.type() != result.type())
+                {
+                    throw std::logic_error("execution_plan: local operators must preserve the image geometry");
+                }
+
+                auto out = result(tile.tile);
+
+                src(rect{ tile.tile.x - tile.area.x, tile.tile.y - tile.area.y, tile.tile.width, tile.tile.height })
+                    .copyTo(out);
+            }
+
+            return result;
+        }
+
+        void execution_plan::run(program_t const& program, matrix& dst, matrix& src, bool const owned,
+                                 matrix_allocator* const results)
+        {
+            auto is_first = true;
+
+            for (auto const& step : program)
+            {
+                if (step.resolved)
+                {
+                    execute(step, dst, src, is_first, owned, results);
+
+                    continue;
+                }
+
+                for (auto k = step.first; k < step.first + step.count; )
+                {
+                    auto group = step_t{ };
+
+                    auto const depth = src.depth();
+
+                    auto end = k;
+
+                    while (end < step.first + step.count and
+                           (m_chain[end]->traits().pointwise & (1u << depth)) != 0u)
+                    {
+                        ++end;
+                    }
+
+                    group.first    = k;
+                    group.count    = src.empty() ? 1 : std::max<std::size_t>(end - k, 1);
+                    group.in_place = group.count > 1 or m_chain[k]->traits().in_place;
+
+                    execute(group, dst, src, is_first, owned, results);
+
+                    k += group.count;
+                }
+            }
+
+            // REMARK: An operator may give back its source as its result,
+            //         never hand a scratch buffer to the caller.
+
+            if (m_scratch.holds(src))
+            {
+                src = src.clone();
+            }
+        }
+
+        void execution_plan::execute(step_t const& step, matrix& dst, matrix& src, bool& first, bool const owned,
+                                     matrix_allocator* const results)
+        {
+            auto const op = std::next(m_chain.begin(), static_cast<std::ptrdiff_t>(step.first));
+
+            // REMARK: Whether the source is shared is only known now, the
+            //         rest was decided when the plan was built. The first
+            //         step gets an empty destination, as in apply_chain.
+
+            if (step.in_place and detail::unshared(src))
+            {
+                dst = src;
+            }
+            else if (step.scratch and not first)
+            {
+                dst = m_scratch.header(*step.shape, src);
+            }
+
+            if (step.first + step.count == m_chain.size())
+            {
+                dst.allocator = results;
+            }
+            else if (auto* const allocator = matrix_allocator::current())
+            {
+                dst.allocator = allocator;
+            }
+
+            auto input = detail::hold_input(dst, src, owned and first);
+
+            CVIP_PROFILE_STAGE_BEGIN(**op, step.first, dst, src);
+
+            if (step.count > 1)
+            {
+                operator_expression::apply_fused(dst, src, op, std::next(op, static_cast<std::ptrdiff_t>(step.count)),
+                                                 first);
+            }
+            else
+            {
+                (*op)->apply(dst, src, first);
+            }
+
+            CVIP_PROFILE_STAGE_END(dst);
+
+            // REMARK: The result may outlive the allocator, see
+            //         operator_expression::apply_chain.
+
+            dst.allocator = nullptr;
+
+            auto const& shape = step.shape;
+
+            if (shape and (dst.rows != shape->rows or dst.cols != shape->cols or dst.type() != shape->type))
+            {
+                throw std::logic_error("execution_plan: an operator produced an output other than the inferred one");
+            }
+
+            cvip::swap(dst, src);
+
+            // REMARK: After an in-place step both may be on the same buffer,
+            //         see operator_expression::apply_chain.
+
+            if (dst.data == src.data)
+            {
+                dst = matrix{ };
+            }
+
+            detail::hand_over_input(input, dst, src);
+
+            first = false;
+        }
+
+    }
+
+}
@@ -10,9 +10,21 @@
 // See LICENSE file in the project root for full license information.
 //
 
+#include <cvip/execution_plan.hpp>
 #include <cvip/expression.hpp>
 #include <cvip/internal/basic_imports.hpp>
+#include <cvip/internal/ownership.hpp>
+#include <cvip/internal/pointwise.hpp>
+#include <cvip/internal/predicate_traits.hpp>
+#include <cvip/mapped_image.hpp>
+#include <cvip/profiling.hpp>
+#include <algorithm>
+#include <cmath>
 #include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 
 namespace cvip
@@ -27,32 +39,808 @@ namespace cvip
             // NOOP
         }
 
+        operator_expression operator_expression::clone() const
+        {
+            auto ex = operator_expression{ *this };
+
+            ex.m_data.detach();
+
+            return ex;
+        }
+
+        void operator_expression::optimize(rewrite_rules const& rules)
+        {
+            // REMARK: A faulty set of rules, e.g. a rule and its inverse,
+            //         could rewrite the chain forever, so the number of
+            //         passes is bounded.
+
+            static auto constexpr max_passes = 64;
+
+            auto passes = 0;
+
+            while (passes < max_passes and rewrite_pass(rules))
+            {
+                ++passes;
+            }
+
+            m_shapes.clear();
+
+            m_stages.stages.clear();
+
+            if (passes == max_passes)
+            {
+                throw std::runtime_error("operator_expression: the rewrite rules do not converge");
+            }
+        }
+
         matrix operator_expression::apply(matrix const& rhs_im)
         {
-            auto src = matrix{ rhs_im };
-            auto dst = matrix{ };
+            // REMARK: The header copy shares the caller's data, so it is
+            //         never taken as a processing buffer.
 
-            auto first = true;
+            return apply(matrix{ rhs_im });
+        }
 
-            for (auto& op : *m_data)
+        matrix operator_expression::apply(matrix&& rhs_im)
+        {
+            if (m_data.empty())
             {
-                op->apply(dst, src, first);
+                return detail::unshared(rhs_im) ? std::move(rhs_im) : rhs_im.clone();
+            }
 
-                cvip::swap(dst, src);
+            if (m_cache)
+            {
+                if (auto const fingerprint = chain_fingerprint())
+                {
+                    auto const key = result_cache::make_key(*fingerprint, rhs_im);
+
+                    if (auto cached = m_cache->find(key))
+                    {
+                        return std::move(*cached);
+                    }
+
+                    // REMARK: The result is shared with the cache, it is held
+                    //         by both, so it is never overwritten in place.
+
+                    auto result = compute(std::move(rhs_im));
+
+                    m_cache->insert(key, result);
+
+                    return result;
+                }
+            }
+
+            return compute(std::move(rhs_im));
+        }
+
+        matrix operator_expression::compute(matrix&& rhs_im)
+        {
+            if (m_stages.enabled)
+            {
+                return apply_incremental(rhs_im);
+            }
 
-                first = false;
+            if (m_tile_cache > 0)
+            {
+                auto const halo = chain_halo();
+
+                if (halo >= 0)
+                {
+                    return apply_tiled(rhs_im, halo);
+                }
             }
 
+            // REMARK: An input owned by the expression is not the caller's
+            //         image, it may be overwritten or become the destination
+            //         of the second stage.
+
+            auto src = matrix{ std::move(rhs_im) };
+            auto dst = matrix{ };
+
+            apply_chain(dst, src, detail::unshared(src));
+
             // REMARK: The result is in src due to the swap
             //         at the end of each iteration!
 
             return src;
         }
 
-        inline operator_expression::exdata_t operator_expression::construct_data(i_operator const& lhs_op,
-                                                                                 i_operator const& rhs_op)
+        matrix operator_expression::apply_tiled(matrix const& rhs_im, int const halo)
         {
-            return std::make_shared<opchain_t>(opchain_t{ rhs_op.clone(), lhs_op.clone() });
+            auto const side = tile_side({ rhs_im.rows, rhs_im.cols, rhs_im.type() }, halo);
+
+            if (side == 0)
+            {
+                auto src = matrix{ rhs_im };
+                auto dst = matrix{ };
+
+                apply_chain(dst, src);
+
+                return src;
+            }
+
+            auto const bounds = rect{ 0, 0, rhs_im.cols, rhs_im.rows };
+
+            auto result = matrix{ };
+
+            for (auto y = 0; y < rhs_im.rows; y += side)
+            {
+                for (auto x = 0; x < rhs_im.cols; x += side)
+                {
+                    auto const tile = rect{ x, y, side, side } & bounds;
+                    auto const area = rect{ x - halo, y - halo, side + 2 * halo, side + 2 * halo } & bounds;
+
+                    auto src = rhs_im(area);
+                    auto dst = matrix{ };
+
+                    apply_chain(dst, src);
+
+                    // REMARK: The result is in src due to the swap
+                    //         at the end of each iteration!
+
+                    if (result.empty() and m_pool)
+                    {
+                        result = m_pool->acquire(rhs_im.rows, rhs_im.cols, src.type());
+                    }
+                    else if (result.empty())
+                    {
+                        result.allocator = stage_allocator(true);
+                        result.create(rhs_im.rows, rhs_im.cols, src.type());
+                        result.allocator = nullptr;
+                    }
+
+                    if (src.rows != area.height or src.cols != area.width or src.type() != result.type())
+                    {
+                        throw std::logic_error("operator_expression: local operators must preserve the image geometry");
+                    }
+
+                    auto out = result(tile);
+
+                    src(rect{ tile.x - area.x, tile.y - area.y, tile.width, tile.height }).copyTo(out);
+                }
+            }
+
+            return result;
+        }
+
+        execution_plan operator_expression::compile(matrix_shape const& input)
+        {
+            auto const halo = m_tile_cache > 0 ? chain_halo() : -1;
+            auto const side = halo >= 0 ? tile_side(input, halo) : 0;
+
+            return execution_plan{ m_data, input, side, std::max(halo, 0) };
+        }
+
+        void operator_expression::apply_region(matrix const& rhs_im, rect const& region, matrix& output)
+        {
+            auto const halo = chain_halo();
+
+            if (halo < 0)
+            {
+                throw std::invalid_argument("operator_expression: a region needs local operators");
+            }
+
+            auto const bounds = rect{ 0, 0, rhs_im.cols, rhs_im.rows };
+
+            if (region.empty() or (region & bounds) != region)
+            {
+                throw std::out_of_range("operator_expression: the region is out of the image");
+            }
+
+            // REMARK: Each stage needs its input grown by its own halo, so
+            //         the first one gets the region grown by all of them,
+            //         or up to the image border, as on the whole image.
+
+            auto const area = rect{ region.x - halo, region.y - halo, region.width + 2 * halo, region.height + 2 * halo }
+                            & bounds;
+
+            auto src = rhs_im(area);
+            auto dst = matrix{ };
+
+            apply_chain(dst, src);
+
+            // REMARK: The result is in src due to the swap
+            //         at the end of each iteration!
+
+            if (src.rows != area.height or src.cols != area.width)
+            {
+                throw std::logic_error("operator_expression: local operators must preserve the image geometry");
+            }
+
+            auto const inner = src(rect{ region.x - area.x, region.y - area.y, region.width, region.height });
+
+            if (output.empty())
+            {
+                // REMARK: An empty chain gives back the input region.
+
+                output = m_data.empty() ? inner.clone() : inner;
+
+                return;
+            }
+
+            if (output.rows != region.height or output.cols != region.width or output.type() != inner.type())
+            {
+                throw std::invalid_argument("operator_expression: the output must have the size and type of the result");
+            }
+
+            inner.copyTo(output);
+        }
+
+        void operator_expression::stream(mapped_image const& input, mapped_image& output, std::size_t const band_size)
+        {
+            auto const halo = chain_halo();
+
+            if (halo < 0)
+            {
+                throw std::invalid_argument("operator_expression: streaming needs local operators");
+            }
+
+            auto const shape  = input.shape();
+            auto const target = output.shape();
+
+            if (target.rows != shape.rows or target.cols != shape.cols)
+            {
+                throw std::invalid_argument("operator_expression: the output must have the size of the input");
+            }
+
+            if (auto const inferred = infer(shape); inferred and inferred->type != target.type)
+            {
+                throw std::invalid_argument("operator_expression: the output must have the type of the result");
+            }
+
+            auto const row_size = static_cast<std::size_t>(shape.cols) * CV_ELEM_SIZE(shape.type);
+            auto const band     = static_cast<int>(std::clamp<std::size_t>(band_size / row_size, 1, shape.rows));
+
+            auto released = 0;  // input rows before this one were dropped
+
+            for (auto y = 0; y < shape.rows; y += band)
+            {
+                auto const rows  = std::min(band, shape.rows - y);
+                auto const first = std::max(y - halo, 0);
+                auto const last  = std::min(y + rows + halo, shape.rows);
+
+                auto src = input.rows(first, last - first);
+                auto dst = matrix{ };
+
+                apply_chain(dst, src);
+
+                // REMARK: The result is in src due to the swap
+                //         at the end of each iteration!
+
+                if (src.rows != last - first or src.cols != shape.cols)
+                {
+                    throw std::logic_error("operator_expression: local operators must preserve the image geometry");
+                }
+
+                if (src.type() != target.type)
+                {
+                    throw std::invalid_argument("operator_expression: the output must have the type of the result");
+                }
+
+                auto out = output.rows(y, rows);
+
+                src.rowRange(y - first, y - first + rows).copyTo(out);
+
+                output.release(y, rows);
+
+                // REMARK: The next band reads from halo rows before its
+                //         first one on.
+
+                auto const needed = std::max(y + rows - halo, 0);
+
+                if (needed > released)
+                {
+                    input.release(released, needed - released);
+
+                    released = needed;
+                }
+            }
+        }
+
+        matrix operator_expression::apply_incremental(matrix const& rhs_im)
+        {
+            auto& stages = m_stages.stages;
+
+            // REMARK: The input is identified by its shape and the hash of
+            //         its content, not by its data, which the caller may
+            //         reuse for another image, e.g. a capture buffer.
+
+            auto const input = result_cache::make_key(0, rhs_im);
+
+            auto const same_input = m_stages.input == input;
+
+            // Find the first stage to recompute: all of them if the input
+            // changed, otherwise, the first one whose operator was replaced
+            // or retuned since it was applied.
+
+            auto dirty = std::size_t{ 0 };
+
+            if (same_input and not rhs_im.empty() and stages.size() == m_data.size())
+            {
+                for (auto const& op : m_data)
+                {
+                    auto const& kept = stages[dirty];
+
+                    if (kept.op != op or kept.revision != op->revision())
+                    {
+                        break;
+                    }
+
+                    ++dirty;
+                }
+            }
+
+            m_stages.input = input;
+
+            stages.resize(m_data.size());
+
+            auto src   = dirty == 0 ? rhs_im : stages[dirty - 1].result;
+            auto stage = std::size_t{ 0 };
+
+            for (auto& op : m_data)
+            {
+                if (stage >= dirty)
+                {
+                    auto dst = matrix{ };
+
+                    CVIP_PROFILE_STAGE_BEGIN(*op, stage, dst, src);
+
+                    op->apply(dst, src, true);
+
+                    CVIP_PROFILE_STAGE_END(dst);
+
+                    stages[stage] = { op, op->revision(), dst };
+
+                    src = dst;
+                }
+
+                ++stage;
+            }
+
+            // REMARK: The kept results must not be modified by the caller.
+
+            return stages.back().result.clone();
+        }
+
+        i_operator& operator_expression::stage_at(std::size_t const index)
+        {
+            if (index >= m_data.size())
+            {
+                throw std::out_of_range("operator_expression: stage index out of range");
+            }
+
+            // REMARK: The operator is about to be retuned, so the chain is
+            //         copied first if another expression holds it. The
+            //         kept stages refer to the operators of the old copy.
+
+            if (m_data.detach())
+            {
+                m_stages.stages.clear();
+            }
+
+            return *m_data[index];
+        }
+
+        void operator_expression::apply_chain(matrix& dst, matrix& src, bool const owned)
+        {
+            plan({ src.rows, src.cols, src.type() });
+
+            if (m_pool)
+            {
+                m_shapes.resize(m_data.size());
+            }
+
+            auto is_first = true;
+            auto stage    = std::size_t{ 0 };
+
+            auto* const allocator = stage_allocator();
+            auto* const results   = stage_allocator(true);
+
+            for (auto op = m_data.begin(); op != m_data.end(); )
+            {
+                auto const end   = pointwise_end(op, src.depth());
+                auto const fused = std::distance(op, end) > 1 and not src.empty();
+                auto const next  = fused ? end : std::next(op);
+
+                auto const& planned = m_plan[stage + static_cast<std::size_t>(std::distance(op, next)) - 1];
+
+                // REMARK: A stage may overwrite its source only when no one
+                //         else holds it, in particular, never the input of
+                //         the expression; fused runs always work in place.
+                //         The result of the last stage is handed to the
+                //         caller, it is never a scratch buffer. The first
+                //         stage gets an empty destination, even from a pool.
+
+                if ((fused or (*op)->traits().in_place) and detail::unshared(src))
+                {
+                    dst = src;
+                }
+                else if (planned and next != m_data.end() and not is_first)
+                {
+                    dst = m_scratch.header(*planned, src);
+                }
+                else if (m_pool and not is_first)
+                {
+                    recycle(dst, stage);
+                }
+
+                if (next == m_data.end())
+                {
+                    dst.allocator = results;
+                }
+                else if (allocator != nullptr)
+                {
+                    dst.allocator = allocator;
+                }
+
+                auto input = detail::hold_input(dst, src, owned and is_first);
+
+                CVIP_PROFILE_STAGE_BEGIN(**op, stage, dst, src);
+
+                if (fused)
+                {
+                    apply_fused(dst, src, op, end, is_first);
+                }
+                else
+                {
+                    (*op)->apply(dst, src, is_first);
+                }
+
+                CVIP_PROFILE_STAGE_END(dst);
+
+                // REMARK: The data keeps the pool of the allocator alive,
+                //         the header must not keep a pointer to it, the
+                //         result may outlive the allocator.
+
+                dst.allocator = nullptr;
+
+                if (planned and (dst.rows != planned->rows or dst.cols != planned->cols or dst.type() != planned->type))
+                {
+                    throw std::logic_error("operator_expression: an operator produced an output other than the inferred one");
+                }
+
+                for (; op != next; ++op, ++stage)
+                {
+                    if (m_pool)
+                    {
+                        m_shapes[stage] = { dst.rows, dst.cols, dst.type() };
+                    }
+                }
+
+                cvip::swap(dst, src);
+
+                // REMARK: After an in-place or fused stage both may be on
+                //         the same buffer, the next stage must not get its
+                //         source as its destination unless it asks for it.
+
+                if (dst.data == src.data)
+                {
+                    dst = matrix{ };
+                }
+
+                detail::hand_over_input(input, dst, src);
+
+                is_first = false;
+            }
+
+            // REMARK: An operator may give back its source as its result,
+            //         never hand a scratch buffer to the caller.
+
+            if (m_scratch.holds(src))
+            {
+                src = src.clone();
+            }
+        }
+
+        std::optional<matrix_shape> operator_expression::infer(matrix_shape const& input) const
+        {
+            auto shape = std::optional<matrix_shape>{ input };
+
+            for (auto const& op : m_data)
+            {
+                if (not shape)
+                {
+                    break;
+                }
+
+                shape = op->infer(*shape);
+            }
+
+            return shape;
+        }
+
+        void operator_expression::plan(matrix_shape const& input)
+        {
+            // Infer the output shape of each stage, as far as the operators
+            // declare it, so that an unsupported input is reported before any
+            // pixel work, and size the scratch buffers for the intermediate
+            // results. Two buffers are enough, as each stage only reads the
+            // result of the previous one.
+
+            m_plan.resize(m_data.size());
+
+            auto shape = std::optional<matrix_shape>{ };
+            auto bytes = std::size_t{ 0 };
+            auto stage = std::size_t{ 0 };
+
+            if (input.rows > 0 and input.cols > 0)
+            {
+                shape = input;
+            }
+
+            for (auto const& op : m_data)
+            {
+                shape = shape ? op->infer(*shape) : std::nullopt;
+
+                m_plan[stage] = shape;
+
+                if (shape and stage + 1 < m_data.size())
+                {
+                    auto const elem_size = static_cast<std::size_t>(CV_ELEM_SIZE(shape->type));
+
+                    bytes = std::max(bytes, static_cast<std::size_t>(shape->rows) * shape->cols * elem_size);
+                }
+
+                ++stage;
+            }
+
+            m_scratch.reserve(bytes, stage_allocator());
+        }
+
+        void operator_expression::recycle(matrix& dst, std::size_t const stage)
+        {
+            // Hand the operator a buffer of the size and type it produced in
+            // the last application, unless the current one already fits.
+
+            auto const& shape = m_shapes[stage];
+
+            if (shape.rows == 0 or shape.cols == 0)
+            {
+                return;
+            }
+
+            if (dst.rows != shape.rows or dst.cols != shape.cols or dst.type() != shape.type)
+            {
+                dst = m_pool->acquire(shape.rows, shape.cols, shape.type);
+            }
+        }
+
+        int operator_expression::tile_side(matrix_shape const& input, int const halo) const
+        {
+            // The side of the tiles is chosen so that a grown tile and  its
+            // processing buffer fit in the cache budget. Tiles smaller than
+            // min_tile_side would spend most of the work on their halos.
+            // Zero if the image fits in a single tile.
+
+            static auto constexpr min_tile_side = 32;
+
+            auto const pixels = static_cast<double>(m_tile_cache) / (2.0 * CV_ELEM_SIZE(input.type));
+            auto const side   = std::max(static_cast<int>(std::sqrt(pixels)) - 2 * halo, min_tile_side);
+
+            return side >= input.rows and side >= input.cols ? 0 : side;
+        }
+
+        int operator_expression::chain_halo() const
+        {
+            auto halo = 0;
+
+            for (auto const& op : m_data)
+            {
+                auto const op_halo = op->traits().halo;
+
+                if (op_halo < 0)
+                {
+                    return -1;
+                }
+
+                halo += op_halo;
+            }
+
+            return halo;
+        }
+
+        std::optional<std::size_t> operator_expression::chain_fingerprint() const
+        {
+            auto fingerprint = std::size_t{ 0 };
+
+            for (auto const& op : m_data)
+            {
+                auto const op_fingerprint = op->traits().fingerprint;
+
+                if (not op_fingerprint)
+                {
+                    return std::nullopt;
+                }
+
+                fingerprint = detail::hash_combine(fingerprint, *op_fingerprint);
+            }
+
+            return fingerprint;
+        }
+
+        bool operator_expression::rewrite_pass(rewrite_rules const& rules)
+        {
+            // REMARK: The rewritten chain is built aside, the new operators
+            //         are kept alive by the rules results until copied.
+
+            auto ops     = std::vector<i_operator const*>{ };
+            auto results = std::vector<operator_chain>{ };
+            auto changed = false;
+
+            auto const replace = [&ops, &results, &changed](operator_chain&& chain)
+            {
+                for (auto const& op : chain)
+                {
+                    ops.push_back(op.get());
+                }
+
+                results.push_back(std::move(chain));
+
+                changed = true;
+            };
+
+            // REMARK: Go on after the new operators, so that a rule can not
+            //         rewrite its own result forever.
+
+            for (auto op = m_data.begin(); op != m_data.end(); )
+            {
+                auto const next = std::next(op);
+
+                if ((*op)->traits().identity)
+                {
+                    replace({ });
+
+                    op = next;
+                }
+                else if (auto unary = rules.rewrite(**op))
+                {
+                    replace(std::move(*unary));
+
+                    op = next;
+                }
+                else if (next == m_data.end())
+                {
+                    ops.push_back(*op);
+
+                    ++op;
+                }
+                else if (auto binary = rules.rewrite(**op, **next))
+                {
+                    replace(std::move(*binary));
+
+                    op = std::next(next);
+                }
+                else
+                {
+                    ops.push_back(*op);
+
+                    ++op;
+                }
+            }
+
+            if (changed)
+            {
+                auto chain = opchain_t{ };
+
+                for (auto const* op : ops)
+                {
+                    chain.push_back(*op);
+                }
+
+                m_data = std::move(chain);
+            }
+
+            return changed;
+        }
+
+        operator_expression::opchain_t::iterator operator_expression::pointwise_end(opchain_t::iterator op,
+                                                                                    int const depth) const noexcept
+        {
+            for (; op != m_data.end(); ++op)
+            {
+                if (((*op)->traits().pointwise & (1u << depth)) == 0u)
+                {
+                    break;
+                }
+            }
+
+            return op;
+        }
+
+        matrix_allocator* operator_expression::stage_allocator(bool const result) const noexcept
+        {
+            if (m_allocator)
+            {
+                return m_allocator.get();
+            }
+
+            return result ? matrix_allocator::current_for_results() : matrix_allocator::current();
+        }
+
+        void operator_expression::apply_fused(matrix& dst, matrix& src, opchain_t::const_iterator op,
+                                              opchain_t::const_iterator end, bool const first)
+        {
+            // Each span is read from src by the first kernel and written to
+            // dst, the remaining kernels update it in place while it is still
+            // in the cache.
+
+            auto const depth = src.depth();
+
+            detail::for_each_span(src, dst, [op, end, depth](void const* in, void* out, int const count)
+            {
+                (*op)->map(in, out, count, depth);
+
+                for (auto kernel = std::next(op); kernel != end; ++kernel)
+                {
+                    (*kernel)->map(out, out, count, depth);
+                }
+            });
+
+            // REMARK: As a predicate would do, do not keep a reference
+            //         to the original operand, the next stage could use
+            //         it as its destination!
+
+            if (first)
+            {
+                src = matrix{ };
+            }
+        }
+
+        inline operator_expression::opchain_t operator_expression::construct_data(i_operator const& lhs_op,
+                                                                                  i_operator const& rhs_op)
+        {
+            // REMARK: The first operator allocates room for a few more, so
+            //         that building a short chain allocates once.
+
+            auto data = opchain_t{ };
+
+            data.push_back(rhs_op);
+            data.push_back(lhs_op);
+
+            return data;
+        }
+
+
+        // operator_expression::opscratch_t
+        //
+
+        void operator_expression::opscratch_t::reserve(std::size_t const bytes, matrix_allocator* const allocator)
+        {
+            static auto constexpr scratch_cols = 4096;
+
+            for (auto& buffer : buffers)
+            {
+                if (buffer.total() < bytes)
+                {
+                    buffer.allocator = allocator;
+                    buffer.create(static_cast<int>((bytes + scratch_cols - 1) / scratch_cols), scratch_cols, CV_8UC1);
+                    buffer.allocator = nullptr;
+                }
+            }
+        }
+
+        matrix operator_expression::opscratch_t::header(matrix_shape const& shape, matrix const& src) const
+        {
+            // REMARK: Use the buffer src is not in, the headers do not own
+            //         the data, so, they are never taken as unshared.
+
+            auto const& buffer = buffers[0].data == src.data ? buffers[1] : buffers[0];
+
+            return matrix(shape.rows, shape.cols, shape.type, buffer.data);
+        }
+
+        bool operator_expression::opscratch_t::holds(matrix const& mat) const noexcept
+        {
+            for (auto const& buffer : buffers)
+            {
+                if (mat.data != nullptr and buffer.data != nullptr and
+                    mat.data >= buffer.data and mat.data < buffer.data + buffer.total())
+                {
+                    return true;
+                }
+            }
+
+            return false;
         }
 
     }
@@ -0,0 +1,113 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+
+#include <cvip/frozen.hpp>
+#include <utility>
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        frozen_expression::frozen_expression(operator_expression const& ex) :
+            m_state{ std::make_shared<state_t>(ex.clone()) }
+        {
+            // NOOP
+        }
+
+        std::size_t frozen_expression::contexts() const
+        {
+            auto const lock = std::lock_guard<std::mutex>{ m_state->lock };
+
+            return m_state->count;
+        }
+
+        matrix operator*(frozen_expression const& lhs_ex, matrix const& rhs_im)
+        {
+            return lhs_ex.apply(matrix{ rhs_im });
+        }
+
+        matrix operator*(frozen_expression const& lhs_ex, matrix&& rhs_im)
+        {
+            return lhs_ex.apply(std::move(rhs_im));
+        }
+
+        matrix frozen_expression::apply(matrix&& rhs_im) const
+        {
+            auto context = acquire();
+
+            try
+            {
+                auto result = context->apply(std::move(rhs_im));
+
+                release(std::move(context));
+
+                return result;
+            }
+            catch (...)
+            {
+                release(std::move(context));
+
+                throw;
+            }
+        }
+
+        frozen_expression::context_t frozen_expression::acquire() const
+        {
+            {
+                auto const lock = std::lock_guard<std::mutex>{ m_state->lock };
+
+                if (not m_state->idle.empty())
+                {
+                    auto context = std::move(m_state->idle.back());
+
+                    m_state->idle.pop_back();
+
+                    return context;
+                }
+            }
+
+            // REMARK: A new context copies the chain, not the operators,
+            //         and the copy is made outside the lock.
+
+            auto context = std::make_unique<operator_expression>(m_state->chain);
+
+            auto const lock = std::lock_guard<std::mutex>{ m_state->lock };
+
+            ++m_state->count;
+
+            return context;
+        }
+
+        void frozen_expression::release(context_t context) const noexcept
+        {
+            auto const lock = std::lock_guard<std::mutex>{ m_state->lock };
+
+            try
+            {
+                m_state->idle.push_back(std::move(context));
+            }
+            catch (...)
+            {
+                // REMARK: Out of memory, the context is dropped and made
+                //         again when needed.
+
+                --m_state->count;
+            }
+        }
+
+    }
+
+}
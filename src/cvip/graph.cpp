@@ -0,0 +1,259 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#include <cvip/graph.hpp>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        operator_graph::operator_graph() :
+            m_nodes(1)
+        {
+            // NOOP
+        }
+
+        operator_graph::node_t operator_graph::add(i_operator const& op, node_t const source)
+        {
+            auto function = [node = op.clone()](std::vector<matrix>& inputs)
+            {
+                return *node * std::move(inputs.front());
+            };
+
+            return add_node({ source }, std::move(function));
+        }
+
+        operator_graph::node_t operator_graph::add(operator_expression const& ex, node_t const source)
+        {
+            auto function = [clone = std::make_shared<operator_expression>(ex.clone())](std::vector<matrix>& inputs)
+            {
+                return *clone * std::move(inputs.front());
+            };
+
+            return add_node({ source }, std::move(function));
+        }
+
+        operator_graph::node_t operator_graph::combine(combiner_t combiner, std::vector<node_t> const& sources)
+        {
+            if (not combiner or sources.empty())
+            {
+                throw std::invalid_argument("operator_graph: a combiner needs a function and some sources");
+            }
+
+            auto function = [combiner = std::move(combiner)](std::vector<matrix>& inputs)
+            {
+                return combiner(inputs);
+            };
+
+            return add_node(sources, std::move(function));
+        }
+
+        std::size_t operator_graph::size() const noexcept
+        {
+            return m_nodes.size();
+        }
+
+        std::vector<matrix> operator_graph::apply(matrix const& rhs_im, std::vector<node_t> const& outputs,
+                                                  execution_model const model, task_scheduler& scheduler)
+        {
+            auto const count = m_nodes.size();
+
+            if (outputs.empty())
+            {
+                return { };
+            }
+
+            // Find the nodes the outputs depend on, nodes are numbered
+            // after their sources, so a single backward sweep is enough.
+
+            auto needed = std::vector<bool>(count, false);
+
+            for (auto const output : outputs)
+            {
+                if (output >= count)
+                {
+                    throw std::out_of_range("operator_graph: unknown output node");
+                }
+
+                needed[output] = true;
+            }
+
+            auto consumers = std::vector<std::vector<node_t>>(count);
+
+            auto pending = std::vector<std::atomic<std::size_t>>(count);  // sources not yet computed
+            auto uses    = std::vector<std::atomic<std::size_t>>(count);  // reads of the result not yet done
+
+            auto remaining = std::atomic<std::size_t>{ 0 };  // needed nodes not yet done
+
+            for (auto node = count; node-- > 0; )
+            {
+                if (not needed[node])
+                {
+                    continue;
+                }
+
+                ++remaining;
+
+                pending[node] = m_nodes[node].sources.size();
+
+                for (auto const source : m_nodes[node].sources)
+                {
+                    needed[source] = true;
+
+                    consumers[source].push_back(node);
+
+                    ++uses[source];
+                }
+            }
+
+            // REMARK: The results of the outputs are read once more, at the
+            //         end, so they are never handed over to a consumer.
+
+            for (auto const output : outputs)
+            {
+                uses[output] = uses[output] + 1;
+            }
+
+            auto results = std::vector<matrix>(count);
+
+            auto error      = std::exception_ptr{ };
+            auto error_lock = std::mutex{ };
+            auto failed     = std::atomic<bool>{ false };
+
+            results[input] = rhs_im;
+
+            std::function<void(node_t)> run;
+
+            auto const schedule = [&run, &scheduler, model](node_t const node)
+            {
+                if (model == execution_model::parallel)
+                {
+                    scheduler.submit([&run, node]() { run(node); });
+                }
+            };
+
+            run = [&](node_t const node)
+            {
+                if (node != input and not failed)
+                {
+                    try
+                    {
+                        auto const& sources = m_nodes[node].sources;
+
+                        auto inputs = std::vector<matrix>(sources.size());
+
+                        for (auto k = std::size_t{ 0 }; k < sources.size(); ++k)
+                        {
+                            // REMARK: The last reader takes the result over,
+                            //         every other reader took its copy first.
+
+                            inputs[k] = results[sources[k]];
+
+                            if (uses[sources[k]]-- == 1)
+                            {
+                                inputs[k] = std::move(results[sources[k]]);
+                            }
+                        }
+
+                        results[node] = m_nodes[node].function(inputs);
+                    }
+                    catch (...)
+                    {
+                        auto const lock = std::lock_guard<std::mutex>{ error_lock };
+
+                        if (not error)
+                        {
+                            error = std::current_exception();
+                        }
+
+                        failed = true;
+                    }
+                }
+
+                for (auto const consumer : consumers[node])
+                {
+                    if (pending[consumer]-- == 1)
+                    {
+                        schedule(consumer);
+                    }
+                }
+
+                --remaining;
+            };
+
+            if (model == execution_model::parallel)
+            {
+                run(input);
+
+                scheduler.wait_until([&remaining]() { return remaining == 0; });
+            }
+            else
+            {
+                for (auto node = node_t{ 0 }; node < count; ++node)
+                {
+                    if (needed[node])
+                    {
+                        run(node);
+                    }
+                }
+            }
+
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+
+            auto result = std::vector<matrix>{ };
+
+            result.reserve(outputs.size());
+
+            for (auto const output : outputs)
+            {
+                result.push_back(results[output]);
+            }
+
+            return result;
+        }
+
+        matrix operator_graph::apply(matrix const& rhs_im, node_t const output, execution_model const model,
+                                     task_scheduler& scheduler)
+        {
+            return apply(rhs_im, std::vector<node_t>{ output }, model, scheduler).front();
+        }
+
+        operator_graph::node_t operator_graph::add_node(std::vector<node_t> const& sources, function_t function)
+        {
+            for (auto const source : sources)
+            {
+                if (source >= m_nodes.size())
+                {
+                    throw std::out_of_range("operator_graph: unknown source node");
+                }
+            }
+
+            m_nodes.push_back({ sources, std::move(function) });
+
+            return m_nodes.size() - 1;
+        }
+
+    }
+
+}
@@ -0,0 +1,311 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+
+#include <cvip/mapped_image.hpp>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#if defined(CVIP_TARGET_POSIX_BUILD)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(CVIP_TARGET_WINDOWS_BUILD)
+#include <windows.h>
+#endif // defined(CVIP_TARGET_POSIX_BUILD)
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        namespace
+        {
+
+            [[noreturn]] void throw_system_error(std::string const& what)
+            {
+#if defined(CVIP_TARGET_WINDOWS_BUILD)
+                auto const code = static_cast<int>(::GetLastError());
+
+                throw std::system_error(code, std::system_category(), "mapped_image: " + what);
+#else
+                throw std::system_error(errno, std::generic_category(), "mapped_image: " + what);
+#endif // defined(CVIP_TARGET_WINDOWS_BUILD)
+            }
+
+            std::size_t page_size() noexcept
+            {
+#if defined(CVIP_TARGET_WINDOWS_BUILD)
+                auto info = SYSTEM_INFO{ };
+
+                ::GetSystemInfo(&info);
+
+                return info.dwPageSize;
+#else
+                return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+#endif // defined(CVIP_TARGET_WINDOWS_BUILD)
+            }
+
+        }
+
+
+        mapped_image::mapped_image(std::string const& path, matrix_shape const& shape, access const mode,
+                                   std::size_t const offset) :
+            m_shape{ shape },
+            m_mode{ mode }
+        {
+            if (shape.rows <= 0 or shape.cols <= 0)
+            {
+                throw std::invalid_argument("mapped_image: the image must not be empty");
+            }
+
+            m_step   = static_cast<std::size_t>(shape.cols) * CV_ELEM_SIZE(shape.type);
+            m_length = offset + m_step * static_cast<std::size_t>(shape.rows);
+
+            auto const writable = mode == access::read_write;
+
+#if defined(CVIP_TARGET_POSIX_BUILD)
+
+            auto const file = ::open(path.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+
+            if (file < 0)
+            {
+                throw_system_error("can not open " + path);
+            }
+
+            struct stat status = { };
+
+            auto const sized = ::fstat(file, &status) == 0 and
+                (static_cast<std::size_t>(status.st_size) >= m_length or
+                 (writable and ::ftruncate(file, static_cast<off_t>(m_length)) == 0));
+
+            if (not sized)
+            {
+                ::close(file);
+
+                if (not writable)
+                {
+                    throw std::invalid_argument("mapped_image: " + path + " is smaller than the image");
+                }
+
+                throw_system_error("can not size " + path);
+            }
+
+            auto const view = ::mmap(nullptr, m_length, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED,
+                                     file, 0);
+
+            // REMARK: The mapping keeps the file open.
+
+            ::close(file);
+
+            if (view == MAP_FAILED)
+            {
+                throw_system_error("can not map " + path);
+            }
+
+            m_view = static_cast<unsigned char*>(view);
+
+#elif defined(CVIP_TARGET_WINDOWS_BUILD)
+
+            auto const file = ::CreateFileA(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                                            FILE_SHARE_READ, nullptr, writable ? OPEN_ALWAYS : OPEN_EXISTING,
+                                            FILE_ATTRIBUTE_NORMAL, nullptr);
+
+            if (file == INVALID_HANDLE_VALUE)
+            {
+                throw_system_error("can not open " + path);
+            }
+
+            auto size = LARGE_INTEGER{ };
+
+            if (not writable and (not ::GetFileSizeEx(file, &size) or
+                                  static_cast<std::size_t>(size.QuadPart) < m_length))
+            {
+                ::CloseHandle(file);
+
+                throw std::invalid_argument("mapped_image: " + path + " is smaller than the image");
+            }
+
+            // REMARK: Mapping a writable file grows it to the given size.
+
+            auto const length = static_cast<std::uint64_t>(m_length);
+
+            auto const mapping = ::CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                                      static_cast<DWORD>(length >> 32),
+                                                      static_cast<DWORD>(length & 0xFFFFFFFFu), nullptr);
+
+            ::CloseHandle(file);
+
+            if (mapping == nullptr)
+            {
+                throw_system_error("can not map " + path);
+            }
+
+            auto const view = ::MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, m_length);
+
+            if (view == nullptr)
+            {
+                auto const error = ::GetLastError();
+
+                ::CloseHandle(mapping);
+
+                ::SetLastError(error);
+
+                throw_system_error("can not map " + path);
+            }
+
+            m_view   = static_cast<unsigned char*>(view);
+            m_handle = mapping;
+
+#endif // defined(CVIP_TARGET_POSIX_BUILD)
+
+            m_data = m_view + offset;
+        }
+
+        mapped_image::mapped_image(mapped_image&& src) noexcept :
+            m_shape{ src.m_shape },
+            m_step{ src.m_step },
+            m_view{ std::exchange(src.m_view, nullptr) },
+            m_data{ std::exchange(src.m_data, nullptr) },
+            m_length{ std::exchange(src.m_length, 0) },
+            m_mode{ src.m_mode },
+            m_handle{ std::exchange(src.m_handle, nullptr) }
+        {
+            // NOOP
+        }
+
+        mapped_image::~mapped_image() noexcept
+        {
+            unmap();
+        }
+
+        mapped_image& mapped_image::operator=(mapped_image&& src) noexcept
+        {
+            if (this != &src)
+            {
+                unmap();
+
+                m_shape  = src.m_shape;
+                m_step   = src.m_step;
+                m_view   = std::exchange(src.m_view, nullptr);
+                m_data   = std::exchange(src.m_data, nullptr);
+                m_length = std::exchange(src.m_length, 0);
+                m_mode   = src.m_mode;
+                m_handle = std::exchange(src.m_handle, nullptr);
+            }
+
+            return *this;
+        }
+
+        matrix_shape const& mapped_image::shape() const noexcept
+        {
+            return m_shape;
+        }
+
+        matrix mapped_image::rows(int const first, int const count) const
+        {
+            if (first < 0 or count <= 0 or first + count > m_shape.rows)
+            {
+                throw std::out_of_range("mapped_image: rows out of range");
+            }
+
+            return matrix(count, m_shape.cols, m_shape.type, m_data + static_cast<std::size_t>(first) * m_step, m_step);
+        }
+
+        void mapped_image::release(int const first, int const count) const noexcept
+        {
+            if (m_view == nullptr or first < 0 or count <= 0 or first + count > m_shape.rows)
+            {
+                return;
+            }
+
+            // REMARK: Only whole pages within the rows are dropped, so that
+            //         the neighbouring rows are not read again.
+
+            auto const page = page_size();
+
+            auto const begin = reinterpret_cast<std::uintptr_t>(m_data) + static_cast<std::size_t>(first) * m_step;
+            auto const end   = begin + static_cast<std::size_t>(count) * m_step;
+
+            auto const lower = (begin + page - 1) / page * page;
+            auto const upper = end / page * page;
+
+            if (upper <= lower)
+            {
+                return;
+            }
+
+#if defined(CVIP_TARGET_POSIX_BUILD)
+            ::madvise(reinterpret_cast<void*>(lower), upper - lower, MADV_DONTNEED);
+#elif defined(CVIP_TARGET_WINDOWS_BUILD)
+            // REMARK: Unlocking pages that are not locked removes them from
+            //         the working set.
+
+            ::VirtualUnlock(reinterpret_cast<void*>(lower), upper - lower);
+#endif // defined(CVIP_TARGET_POSIX_BUILD)
+        }
+
+        void mapped_image::flush() const
+        {
+            if (m_view == nullptr or m_mode != access::read_write)
+            {
+                return;
+            }
+
+#if defined(CVIP_TARGET_POSIX_BUILD)
+            if (::msync(m_view, m_length, MS_SYNC) != 0)
+#elif defined(CVIP_TARGET_WINDOWS_BUILD)
+            if (not ::FlushViewOfFile(m_view, m_length))
+#endif // defined(CVIP_TARGET_POSIX_BUILD)
+            {
+                throw_system_error("can not flush the image");
+            }
+        }
+
+        void mapped_image::unmap() noexcept
+        {
+            if (m_view == nullptr)
+            {
+                return;
+            }
+
+#if defined(CVIP_TARGET_POSIX_BUILD)
+            if (m_mode == access::read_write)
+            {
+                ::msync(m_view, m_length, MS_SYNC);
+            }
+
+            ::munmap(m_view, m_length);
+#elif defined(CVIP_TARGET_WINDOWS_BUILD)
+            if (m_mode == access::read_write)
+            {
+                ::FlushViewOfFile(m_view, m_length);
+            }
+
+            ::UnmapViewOfFile(m_view);
+            ::CloseHandle(m_handle);
+#endif // defined(CVIP_TARGET_POSIX_BUILD)
+
+            m_view   = nullptr;
+            m_data   = nullptr;
+            m_handle = nullptr;
+        }
+
+    }
+
+}
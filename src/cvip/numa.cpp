@@ -0,0 +1,332 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+
+#include <cvip/numa.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif // defined(__linux__)
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        namespace
+        {
+
+#if defined(__linux__)
+
+            // First line of a text file, empty if it can not be read
+            //
+
+            std::string read_line(std::string const& path)
+            {
+                auto file = std::ifstream{ path };
+                auto line = std::string{ };
+
+                std::getline(file, line);
+
+                return line;
+            }
+
+
+            // Numbers in a list like "0-3,8,10-11"
+            //
+
+            std::vector<int> parse_list(std::string const& text)
+            {
+                auto list   = std::vector<int>{ };
+                auto stream = std::istringstream{ text };
+                auto range  = std::string{ };
+
+                while (std::getline(stream, range, ','))
+                {
+                    auto const dash  = range.find('-');
+                    auto const first = std::stoi(range.substr(0, dash));
+                    auto const last  = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+
+                    for (auto k = first; k <= last; ++k)
+                    {
+                        list.push_back(k);
+                    }
+                }
+
+                return list;
+            }
+
+#endif // defined(__linux__)
+
+
+            // Processors of each node the process may run on, a single node
+            // with no processors if the topology is not known
+            //
+
+            std::vector<std::vector<int>> detect_nodes()
+            {
+                auto nodes = std::vector<std::vector<int>>{ };
+
+#if defined(__linux__)
+                auto allowed = cpu_set_t{ };
+
+                CPU_ZERO(&allowed);
+
+                auto const restricted = ::sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+                try
+                {
+                    for (auto const node : parse_list(read_line("/sys/devices/system/node/online")))
+                    {
+                        auto const path = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+
+                        auto processors = std::vector<int>{ };
+
+                        for (auto const cpu : parse_list(read_line(path)))
+                        {
+                            if (cpu < CPU_SETSIZE and (not restricted or CPU_ISSET(cpu, &allowed)))
+                            {
+                                processors.push_back(cpu);
+                            }
+                        }
+
+                        if (not processors.empty())
+                        {
+                            nodes.push_back(std::move(processors));
+                        }
+                    }
+                }
+                catch (std::exception const&)
+                {
+                    nodes.clear();
+                }
+#endif // defined(__linux__)
+
+                if (nodes.empty())
+                {
+                    nodes.emplace_back();
+                }
+
+                return nodes;
+            }
+
+
+            // Pin the calling thread to the given processors, if any; it is
+            // a hint, the thread runs anyway
+            //
+
+            void pin(std::vector<int> const& processors [[maybe_unused]]) noexcept
+            {
+#if defined(__linux__)
+                if (processors.empty())
+                {
+                    return;
+                }
+
+                auto set = cpu_set_t{ };
+
+                CPU_ZERO(&set);
+
+                for (auto const cpu : processors)
+                {
+                    CPU_SET(cpu, &set);
+                }
+
+                ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+#endif // defined(__linux__)
+            }
+
+        }
+
+
+        numa_scheduler::node_t::node_t(std::vector<int> cpus, std::size_t const workers, bool const huge_pages,
+                                       std::size_t const pool_capacity) :
+            processors{ std::move(cpus) },
+            allocator{ huge_pages, pool_capacity },
+            scheduler{ workers, [affinity = processors]() { pin(affinity); } }
+        {
+            // NOOP
+        }
+
+        numa_scheduler::numa_scheduler(std::size_t const workers_per_node, bool const huge_pages,
+                                       std::size_t const pool_capacity)
+        {
+            for (auto& processors : detect_nodes())
+            {
+                auto const workers = workers_per_node > 0 ? workers_per_node
+                                   : processors.empty()   ? task_scheduler::default_workers()
+                                   :                        processors.size();
+
+                m_nodes.push_back(std::make_unique<node_t>(std::move(processors), workers, huge_pages, pool_capacity));
+            }
+        }
+
+        numa_scheduler& numa_scheduler::global()
+        {
+            static auto scheduler = numa_scheduler{ };
+
+            return scheduler;
+        }
+
+        std::size_t numa_scheduler::nodes() const noexcept
+        {
+            return m_nodes.size();
+        }
+
+        std::size_t numa_scheduler::workers() const noexcept
+        {
+            auto count = std::size_t{ 0 };
+
+            for (auto const& node : m_nodes)
+            {
+                count += node->scheduler.workers();
+            }
+
+            return count;
+        }
+
+        std::vector<int> const& numa_scheduler::processors(std::size_t const node) const
+        {
+            return m_nodes.at(node)->processors;
+        }
+
+        matrix_allocator const& numa_scheduler::allocator(std::size_t const node) const
+        {
+            return m_nodes.at(node)->allocator;
+        }
+
+        void numa_scheduler::run(std::size_t const frames, std::function<worker_t()> const& make_worker)
+        {
+            auto next    = std::atomic<std::size_t>{ 0 };
+            auto pending = std::size_t{ 0 };  // tasks queued and not done
+
+            auto error = std::exception_ptr{ };
+            auto lock  = std::mutex{ };
+            auto done  = std::condition_variable{ };
+
+            auto const work = [&](node_t& node)
+            {
+                try
+                {
+                    // REMARK: The results are left to the default allocator,
+                    //         so that the blocks of the node are reused by the
+                    //         next frames.
+
+                    auto const scope = allocator_scope{ &node.allocator, false };
+
+                    auto worker = make_worker();
+
+                    for (auto frame = next++; frame < frames; frame = next++)
+                    {
+                        worker(frame);
+                    }
+                }
+                catch (...)
+                {
+                    auto const guard = std::lock_guard<std::mutex>{ lock };
+
+                    if (not error)
+                    {
+                        error = std::current_exception();
+                    }
+
+                    next = frames;
+                }
+
+                // REMARK: Notify under the lock, the waiting thread may
+                //         return, and the condition go, as soon as it is
+                //         released.
+
+                auto const guard = std::lock_guard<std::mutex>{ lock };
+
+                --pending;
+
+                done.notify_all();
+            };
+
+            // REMARK: Workers are taken from the nodes in turn, so that a
+            //         small batch is spread over all of them.
+
+            auto const tasks = std::min(frames, workers());
+
+            auto taken = std::vector<std::size_t>(m_nodes.size(), 0);
+
+            try
+            {
+                for (auto k = std::size_t{ 0 }, node = std::size_t{ 0 }; k < tasks; node = (node + 1) % m_nodes.size())
+                {
+                    auto& target = *m_nodes[node];
+
+                    if (taken[node] == target.scheduler.workers())
+                    {
+                        continue;
+                    }
+
+                    {
+                        auto const guard = std::lock_guard<std::mutex>{ lock };
+
+                        ++pending;
+                    }
+
+                    try
+                    {
+                        target.scheduler.submit([&work, &target]() { work(target); });
+                    }
+                    catch (...)
+                    {
+                        auto const guard = std::lock_guard<std::mutex>{ lock };
+
+                        --pending;
+
+                        throw;
+                    }
+
+                    ++taken[node];
+                    ++k;
+                }
+            }
+            catch (...)
+            {
+                next = frames;
+
+                auto guard = std::unique_lock<std::mutex>{ lock };
+
+                done.wait(guard, [&pending]() { return pending == 0; });
+
+                throw;
+            }
+
+            auto guard = std::unique_lock<std::mutex>{ lock };
+
+            done.wait(guard, [&pending]() { return pending == 0; });
+
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+
+    }
+
+}
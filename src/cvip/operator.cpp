@@ -10,7 +10,12 @@
 // See LICENSE file in the project root for full license information.
 //
 
+#include <cvip/allocator.hpp>
 #include <cvip/i_operator.hpp>
+#include <cvip/internal/ownership.hpp>
+#include <cvip/profiling.hpp>
+#include <stdexcept>
+#include <utility>
 
 
 namespace cvip
@@ -19,13 +24,90 @@ namespace cvip
     namespace core
     {
 
+        std::size_t i_operator::footprint() const noexcept
+        {
+            return 0;
+        }
+
+        i_operator* i_operator::clone_into(void* storage [[maybe_unused]]) const
+        {
+            throw std::logic_error("i_operator: the operator can only be copied with clone");
+        }
+
+        operator_traits i_operator::traits() const
+        {
+            return { };
+        }
+
+        std::optional<matrix_shape> i_operator::infer(matrix_shape const& input) const
+        {
+            // REMARK: A pointwise operator preserves the shape of the inputs
+            //         it has a kernel for.
+
+            if ((traits().pointwise & (1u << CV_MAT_DEPTH(input.type))) != 0u)
+            {
+                return input;
+            }
+
+            return std::nullopt;
+        }
+
+        std::size_t i_operator::revision() const noexcept
+        {
+            return 0;
+        }
+
+        void i_operator::map(void const* src [[maybe_unused]], void* dst [[maybe_unused]],
+                             int const count [[maybe_unused]], int const depth [[maybe_unused]]) const
+        {
+            throw std::logic_error("i_operator: the operator is not pointwise");
+        }
+
         matrix operator*(i_operator& lhs_op, matrix const& rhs_im)
         {
             auto src = matrix{ rhs_im };
             auto dst = matrix{ };
 
+            dst.allocator = matrix_allocator::current_for_results();
+
+            CVIP_PROFILE_STAGE_BEGIN(lhs_op, 0, dst, src);
+
             lhs_op.apply(dst, src, true);
 
+            CVIP_PROFILE_STAGE_END(dst);
+
+            dst.allocator = nullptr;
+
+            return dst;
+        }
+
+        matrix operator*(i_operator& lhs_op, matrix&& rhs_im)
+        {
+            auto src = matrix{ std::move(rhs_im) };
+            auto dst = matrix{ };
+
+            // REMARK: The input is not the caller's image if no one else
+            //         holds it, it may be overwritten.
+
+            auto const owned = detail::unshared(src);
+
+            if (owned and lhs_op.traits().in_place)
+            {
+                dst = src;
+            }
+            else
+            {
+                dst.allocator = matrix_allocator::current_for_results();
+            }
+
+            CVIP_PROFILE_STAGE_BEGIN(lhs_op, 0, dst, src);
+
+            lhs_op.apply(dst, src, true);
+
+            CVIP_PROFILE_STAGE_END(dst);
+
+            dst.allocator = nullptr;
+
             return dst;
         }
 
@@ -0,0 +1,450 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#include <cvip/profiling.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif // defined(__linux__)
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        namespace
+        {
+
+            std::atomic<i_stage_observer*> g_stage_observer = { nullptr };
+
+            thread_local detail::stage_probe* t_active_probe = nullptr;
+
+            stage_shape shape_of(matrix const& mat) noexcept
+            {
+                return { mat.rows, mat.cols, mat.type() };
+            }
+
+            std::size_t bytes_of(matrix const& mat) noexcept
+            {
+                return mat.total() * mat.elemSize();
+            }
+
+            // Apply op on each count of lhs and rhs, into result
+            //
+
+            template<typename Op>
+            stage_counters combine(stage_counters const& lhs, stage_counters const& rhs, Op const& op) noexcept
+            {
+                auto result = stage_counters{ };
+
+                result.cycles       = op(lhs.cycles, rhs.cycles);
+                result.instructions = op(lhs.instructions, rhs.instructions);
+                result.cache_misses = op(lhs.cache_misses, rhs.cache_misses);
+                result.llc_loads    = op(lhs.llc_loads, rhs.llc_loads);
+                result.llc_stores   = op(lhs.llc_stores, rhs.llc_stores);
+
+                return result;
+            }
+
+#if defined(__linux__)
+
+            // The hardware counters of the calling thread, a perf event group
+            // led by the cycle counter, so that all the events are counted
+            // over the same intervals. The events the processor does not
+            // count are left out of the group.
+            //
+
+            class counter_group
+            {
+            public:
+
+                counter_group() noexcept
+                {
+                    using field_t = std::uint64_t stage_counters::*;
+
+                    struct event_t
+                    {
+                        std::uint32_t type;
+                        std::uint64_t config;
+                        field_t       field;
+                    };
+
+                    static auto constexpr llc_read  = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                      (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16);
+                    static auto constexpr llc_write = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_WRITE << 8) |
+                                                      (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16);
+
+                    auto const events = std::array<event_t, 5>{ {
+                        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES,   &stage_counters::cycles },
+                        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, &stage_counters::instructions },
+                        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, &stage_counters::cache_misses },
+                        { PERF_TYPE_HW_CACHE, llc_read,                   &stage_counters::llc_loads },
+                        { PERF_TYPE_HW_CACHE, llc_write,                  &stage_counters::llc_stores },
+                    } };
+
+                    for (auto const& event : events)
+                    {
+                        auto attr = perf_event_attr{ };
+
+                        attr.size           = sizeof(attr);
+                        attr.type           = event.type;
+                        attr.config         = event.config;
+                        attr.read_format    = PERF_FORMAT_GROUP;
+                        attr.exclude_kernel = 1;
+                        attr.exclude_hv     = 1;
+
+                        auto const fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, m_leader, 0));
+
+                        if (fd < 0)
+                        {
+                            if (m_leader < 0)
+                            {
+                                return;
+                            }
+
+                            continue;
+                        }
+
+                        if (m_leader < 0)
+                        {
+                            m_leader = fd;
+                        }
+
+                        m_fds[m_count]    = fd;
+                        m_fields[m_count] = event.field;
+
+                        ++m_count;
+                    }
+                }
+
+                counter_group(counter_group const& src) = delete;
+
+                ~counter_group() noexcept
+                {
+                    for (auto k = std::size_t{ 0 }; k < m_count; ++k)
+                    {
+                        ::close(m_fds[k]);
+                    }
+                }
+
+                counter_group& operator=(counter_group const& src) = delete;
+
+                bool read(stage_counters& counters) const noexcept
+                {
+                    if (m_leader < 0)
+                    {
+                        return false;
+                    }
+
+                    // The group is read as the number of events followed by
+                    // the count of each one, in the order they were added.
+
+                    auto values = std::array<std::uint64_t, 6>{ };
+
+                    auto const size = static_cast<ssize_t>((m_count + 1) * sizeof(std::uint64_t));
+
+                    if (::read(m_leader, values.data(), static_cast<std::size_t>(size)) != size)
+                    {
+                        return false;
+                    }
+
+                    counters = { };
+
+                    for (auto k = std::size_t{ 0 }; k < m_count and k < values[0]; ++k)
+                    {
+                        counters.*m_fields[k] = values[k + 1];
+                    }
+
+                    return true;
+                }
+
+
+            private:
+
+                int m_leader = -1;
+
+                std::size_t m_count = 0;
+
+                std::array<int, 5> m_fds = { };
+
+                std::array<std::uint64_t stage_counters::*, 5> m_fields = { };
+
+            };
+
+#endif // defined(__linux__)
+
+        }
+
+
+        // Stage observer
+        //
+
+        void set_stage_observer(i_stage_observer* observer) noexcept
+        {
+            g_stage_observer.store(observer);
+        }
+
+        i_stage_observer* get_stage_observer() noexcept
+        {
+            return g_stage_observer.load();
+        }
+
+
+        // stage_profiler
+        //
+
+        stage_profiler::stage_profiler(bool const counting) noexcept :
+            m_counting{ counting }
+        {
+            // NOOP
+        }
+
+        void stage_profiler::stage_end(stage_record const& record)
+        {
+            auto const ns = static_cast<std::uint64_t>(std::max<std::int64_t>(record.elapsed.count(), 0));
+
+            auto bucket = std::size_t{ 0 };
+
+            while (bucket + 1 < histogram_t{ }.size() and (ns >> bucket) != 0)
+            {
+                ++bucket;
+            }
+
+            auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+            auto& summary = m_summaries[record.op_type];
+
+            summary.op_type        = record.op_type;
+            summary.calls         += 1;
+            summary.reallocations += record.reallocated ? 1 : 0;
+            summary.bytes         += record.bytes;
+            summary.total         += record.elapsed;
+            summary.min            = std::min(summary.min, record.elapsed);
+            summary.max            = std::max(summary.max, record.elapsed);
+
+            ++summary.histogram[bucket];
+
+            if (record.counted)
+            {
+                summary.counted  += 1;
+                summary.counters  = combine(summary.counters, record.counters, std::plus<std::uint64_t>{ });
+            }
+        }
+
+        bool stage_profiler::counting() const noexcept
+        {
+            return m_counting;
+        }
+
+        std::vector<stage_profiler::summary> stage_profiler::report() const
+        {
+            auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+            auto result = std::vector<summary>{ };
+
+            result.reserve(m_summaries.size());
+
+            for (auto const& item : m_summaries)
+            {
+                result.push_back(item.second);
+            }
+
+            return result;
+        }
+
+        void stage_profiler::reset()
+        {
+            auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+            m_summaries.clear();
+        }
+
+    }
+
+}
+
+
+CVIP_BEGIN_IMPLEMENTATION_DETAILS(cvip::core)
+
+    // Hardware counters
+    //
+
+    bool read_counters(stage_counters& counters [[maybe_unused]]) noexcept
+    {
+#if defined(__linux__)
+        thread_local counter_group const group = { };
+
+        return group.read(counters);
+#else
+        return false;
+#endif // defined(__linux__)
+    }
+
+
+    // stage_probe
+    //
+
+    stage_probe::stage_probe(i_operator const& op, std::size_t const stage, matrix const& dst, matrix const& src) :
+        m_observer{ get_stage_observer() },
+        m_op{ op },
+        m_stage{ stage }
+    {
+        if (m_observer == nullptr)
+        {
+            return;
+        }
+
+        m_input       = shape_of(src);
+        m_input_bytes = bytes_of(src);
+        m_dst_u       = dst.u;
+        m_src_u       = src.u;
+
+        m_observer->stage_begin(m_op, m_stage);
+
+        m_counting = m_observer->counting() and read_counters(m_counters);
+
+        if (m_counting)
+        {
+            m_thread = std::this_thread::get_id();
+            m_outer  = t_active_probe;
+            m_active = true;
+
+            t_active_probe = this;
+        }
+
+        m_start = clock_t::now();
+    }
+
+    stage_probe::~stage_probe() noexcept
+    {
+        deactivate();
+    }
+
+    stage_probe* stage_probe::active() noexcept
+    {
+        return t_active_probe;
+    }
+
+    void stage_probe::deactivate() noexcept
+    {
+        if (m_active)
+        {
+            t_active_probe = m_outer;
+            m_active       = false;
+        }
+    }
+
+    void stage_probe::add_worker(bool const counted, stage_counters const& counters) noexcept
+    {
+        auto const lock = std::lock_guard<std::mutex>{ m_workers_lock };
+
+        m_workers_counted = m_workers_counted and counted;
+        m_workers         = combine(m_workers, counters, std::plus<std::uint64_t>{ });
+    }
+
+    void stage_probe::finish(matrix const& dst)
+    {
+        if (m_observer == nullptr)
+        {
+            return;
+        }
+
+        auto const stop = clock_t::now();
+
+        deactivate();
+
+        auto counters = stage_counters{ };
+
+        // REMARK: The stripes run on other threads have all been joined by
+        //         now, their counts are final.
+
+        auto const counted = m_counting and read_counters(counters) and m_workers_counted;
+
+        // REMARK: Buffers are told by their UMatData, not by their data, so
+        //         that a predicate swapping dst and src, or handing back a
+        //         view on either of them, does not count as a reallocation.
+
+        auto const reallocated = dst.u != nullptr and dst.u != m_dst_u and dst.u != m_src_u;
+
+        auto record = stage_record{ };
+
+        record.op_type     = typeid(m_op);
+        record.stage       = m_stage;
+        record.elapsed     = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - m_start);
+        record.input       = m_input;
+        record.output      = shape_of(dst);
+        record.reallocated = reallocated;
+        record.bytes       = m_input_bytes + bytes_of(dst);
+        record.counted     = counted;
+
+        if (counted)
+        {
+            record.counters = combine(combine(counters, m_counters, std::minus<std::uint64_t>{ }), m_workers,
+                                      std::plus<std::uint64_t>{ });
+        }
+
+        m_observer->stage_end(record);
+    }
+
+
+    // stripe_probe
+    //
+
+    stripe_probe::stripe_probe(stage_probe* const stage) noexcept
+    {
+        // REMARK: The stripes run by the thread applying the operator are
+        //         already counted by its stage probe.
+
+        if (stage == nullptr or stage->m_thread == std::this_thread::get_id())
+        {
+            return;
+        }
+
+        if (not read_counters(m_counters))
+        {
+            stage->add_worker(false, { });
+
+            return;
+        }
+
+        m_stage = stage;
+    }
+
+    stripe_probe::~stripe_probe() noexcept
+    {
+        if (m_stage == nullptr)
+        {
+            return;
+        }
+
+        auto counters = stage_counters{ };
+
+        if (not read_counters(counters))
+        {
+            m_stage->add_worker(false, { });
+
+            return;
+        }
+
+        m_stage->add_worker(true, combine(counters, m_counters, std::minus<std::uint64_t>{ }));
+    }
+
+CVIP_END_IMPLEMENTATION_DETAILS(cvip::core)
@@ -0,0 +1,257 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#include <cvip/result_cache.hpp>
+#include <cvip/internal/predicate_traits.hpp>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        namespace
+        {
+
+            // 128-bit hash, four independent lanes of 8-byte words so that
+            // the multiplications can overlap, as in xxHash64, folded into
+            // two words by two different combinations of the lanes
+            //
+
+            auto constexpr prime1 = std::uint64_t{ 0x9e3779b185ebca87ull };
+            auto constexpr prime2 = std::uint64_t{ 0xc2b2ae3d27d4eb4full };
+            auto constexpr prime3 = std::uint64_t{ 0x165667b19e3779f9ull };
+
+            inline std::uint64_t rotl(std::uint64_t const x, int const r) noexcept
+            {
+                return (x << r) | (x >> (64 - r));
+            }
+
+            inline std::uint64_t mix(std::uint64_t const acc, std::uint64_t const word) noexcept
+            {
+                return rotl(acc + word * prime2, 31) * prime1;
+            }
+
+            inline std::uint64_t load(upix_t const* p) noexcept
+            {
+                auto word = std::uint64_t{ 0 };
+
+                std::memcpy(&word, p, sizeof(word));
+
+                return word;
+            }
+
+            class content_hasher
+            {
+            public:
+
+                void update(upix_t const* p, std::size_t const n) noexcept
+                {
+                    auto i = std::size_t{ 0 };
+
+                    for (; i + 32 <= n; i += 32)
+                    {
+                        m_lane[0] = mix(m_lane[0], load(p + i));
+                        m_lane[1] = mix(m_lane[1], load(p + i + 8));
+                        m_lane[2] = mix(m_lane[2], load(p + i + 16));
+                        m_lane[3] = mix(m_lane[3], load(p + i + 24));
+                    }
+
+                    for (; i < n; ++i)
+                    {
+                        m_tail = rotl(m_tail ^ (p[i] * prime3), 11) * prime1;
+                    }
+
+                    m_length += n;
+                }
+
+                result_cache::content_t digest() const noexcept
+                {
+                    auto const h1 = rotl(m_lane[0], 1) + rotl(m_lane[1], 7) + rotl(m_lane[2], 12) + rotl(m_lane[3], 18);
+                    auto const h2 = rotl(m_lane[0], 18) + rotl(m_lane[1], 12) + rotl(m_lane[2], 7) + rotl(m_lane[3], 1);
+
+                    return { avalanche(h1 ^ (m_tail + m_length)),
+                             avalanche(h2 ^ (m_tail * prime2 + m_length) ^ prime3) };
+                }
+
+            private:
+
+                static std::uint64_t avalanche(std::uint64_t h) noexcept
+                {
+                    h ^= h >> 33;
+                    h *= prime2;
+                    h ^= h >> 29;
+                    h *= prime3;
+                    h ^= h >> 32;
+
+                    return h;
+                }
+
+                std::uint64_t m_lane[4] = { prime1 + prime2, prime2, 0, 0 - prime1 };
+                std::uint64_t m_tail    = 0;
+                std::uint64_t m_length  = 0;
+            };
+
+        }
+
+
+        // result_cache::key_t
+        //
+
+        bool result_cache::key_t::operator==(key_t const& other) const noexcept
+        {
+            return chain == other.chain and content == other.content and
+                   rows == other.rows and cols == other.cols and type == other.type;
+        }
+
+        std::size_t result_cache::key_hash_t::operator()(key_t const& key) const noexcept
+        {
+            auto h = detail::hash_combine(key.chain, static_cast<std::size_t>(key.content[0]));
+
+            h = detail::hash_combine(h, static_cast<std::size_t>(key.rows));
+            h = detail::hash_combine(h, static_cast<std::size_t>(key.cols));
+            h = detail::hash_combine(h, static_cast<std::size_t>(key.type));
+
+            return h;
+        }
+
+
+        // result_cache
+        //
+
+        result_cache::result_cache(std::size_t const capacity) :
+            m_capacity{ capacity }
+        {
+            // NOOP
+        }
+
+        result_cache::key_t result_cache::make_key(std::size_t const chain, matrix const& rhs_im)
+        {
+            return { chain, content_hash(rhs_im), rhs_im.rows, rhs_im.cols, rhs_im.type() };
+        }
+
+        result_cache::content_t result_cache::content_hash(matrix const& mat) noexcept
+        {
+            auto hasher = content_hasher{ };
+
+            auto const row_bytes = static_cast<std::size_t>(mat.cols) * mat.elemSize();
+
+            if (mat.isContinuous())
+            {
+                hasher.update(mat.ptr<upix_t>(0), row_bytes * mat.rows);
+            }
+            else
+            {
+                for (auto y = 0; y < mat.rows; ++y)
+                {
+                    hasher.update(mat.ptr<upix_t>(y), row_bytes);
+                }
+            }
+
+            return hasher.digest();
+        }
+
+        std::optional<matrix> result_cache::find(key_t const& key)
+        {
+            auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+            auto const found = m_index.find(key);
+
+            if (found == m_index.end())
+            {
+                ++m_stats.misses;
+
+                return std::nullopt;
+            }
+
+            ++m_stats.hits;
+
+            m_entries.splice(m_entries.begin(), m_entries, found->second);
+
+            return found->second->result;
+        }
+
+        void result_cache::insert(key_t const& key, matrix const& result)
+        {
+            auto const bytes = bytes_of(result);
+
+            auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+            if (auto const found = m_index.find(key); found != m_index.end())
+            {
+                erase(found->second);
+            }
+
+            if (bytes > m_capacity)
+            {
+                return;
+            }
+
+            while (m_stats.bytes + bytes > m_capacity)
+            {
+                erase(std::prev(m_entries.end()));
+
+                ++m_stats.evictions;
+            }
+
+            m_entries.push_front({ key, result });
+
+            m_index.emplace(key, m_entries.begin());
+
+            m_stats.entries += 1;
+            m_stats.bytes   += bytes;
+        }
+
+        void result_cache::clear()
+        {
+            auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+            m_entries.clear();
+            m_index.clear();
+
+            m_stats.entries = 0;
+            m_stats.bytes   = 0;
+        }
+
+        std::size_t result_cache::capacity() const noexcept
+        {
+            return m_capacity;
+        }
+
+        result_cache::statistics result_cache::stats() const
+        {
+            auto const lock = std::lock_guard<std::mutex>{ m_lock };
+
+            return m_stats;
+        }
+
+        inline std::size_t result_cache::bytes_of(matrix const& mat) noexcept
+        {
+            return mat.total() * mat.elemSize();
+        }
+
+        void result_cache::erase(entries_t::iterator entry)
+        {
+            m_stats.entries -= 1;
+            m_stats.bytes   -= bytes_of(entry->result);
+
+            m_index.erase(entry->key);
+            m_entries.erase(entry);
+        }
+
+    }
+
+}
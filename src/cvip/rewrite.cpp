@@ -0,0 +1,114 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#include <cvip/rewrite.hpp>
+#include <mutex>
+#include <vector>
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        rewrite_rules& rewrite_rules::global()
+        {
+            static auto rules = rewrite_rules{ };
+
+            return rules;
+        }
+
+        void rewrite_rules::clear()
+        {
+            auto const lock = std::unique_lock<std::shared_mutex>{ m_lock };
+
+            m_unary.clear();
+            m_binary.clear();
+        }
+
+        rewrite_t rewrite_rules::rewrite(i_operator const& op) const
+        {
+            // REMARK: The rules are called out of the lock, so that a rule
+            //         may add rules to the set.
+
+            auto rules = std::vector<unary_rule_t>{ };
+
+            {
+                auto const lock = std::shared_lock<std::shared_mutex>{ m_lock };
+
+                auto const found = m_unary.find(typeid(op));
+
+                if (found == m_unary.end())
+                {
+                    return { };
+                }
+
+                rules = found->second;
+            }
+
+            for (auto const& rule : rules)
+            {
+                if (auto result = rule(op))
+                {
+                    return result;
+                }
+            }
+
+            return { };
+        }
+
+        rewrite_t rewrite_rules::rewrite(i_operator const& first, i_operator const& second) const
+        {
+            auto rules = std::vector<binary_rule_t>{ };
+
+            {
+                auto const lock = std::shared_lock<std::shared_mutex>{ m_lock };
+
+                auto const found = m_binary.find({ typeid(first), typeid(second) });
+
+                if (found == m_binary.end())
+                {
+                    return { };
+                }
+
+                rules = found->second;
+            }
+
+            for (auto const& rule : rules)
+            {
+                if (auto result = rule(first, second))
+                {
+                    return result;
+                }
+            }
+
+            return { };
+        }
+
+        void rewrite_rules::add_unary(std::type_index const key, unary_rule_t&& rule)
+        {
+            auto const lock = std::unique_lock<std::shared_mutex>{ m_lock };
+
+            m_unary[key].emplace_back(std::move(rule));
+        }
+
+        void rewrite_rules::add_binary(pair_key_t const& key, binary_rule_t&& rule)
+        {
+            auto const lock = std::unique_lock<std::shared_mutex>{ m_lock };
+
+            m_binary[key].emplace_back(std::move(rule));
+        }
+
+    }
+
+}
@@ -0,0 +1,232 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#include <cvip/scheduler.hpp>
+#include <algorithm>
+#include <utility>
+
+
+namespace cvip
+{
+
+    namespace core
+    {
+
+        namespace
+        {
+
+            // The scheduler the calling thread works for, if any, and the
+            // index of its queue
+            //
+
+            thread_local task_scheduler const* current_scheduler = nullptr;
+            thread_local std::size_t           current_queue     = 0;
+
+        }
+
+
+        task_scheduler::task_scheduler(std::size_t const workers, task_t setup)
+        {
+            auto const count = std::max<std::size_t>(workers, 1);
+
+            m_queues.reserve(count);
+
+            for (auto k = std::size_t{ 0 }; k < count; ++k)
+            {
+                m_queues.emplace_back(std::make_unique<queue_t>());
+            }
+
+            m_threads.reserve(count);
+
+            for (auto k = std::size_t{ 0 }; k < count; ++k)
+            {
+                m_threads.emplace_back([this, k, setup]()
+                {
+                    if (setup)
+                    {
+                        setup();
+                    }
+
+                    work(k);
+                });
+            }
+        }
+
+        task_scheduler::~task_scheduler() noexcept
+        {
+            {
+                auto const lock = std::lock_guard<std::mutex>{ m_idle_lock };
+
+                m_stop = true;
+            }
+
+            m_idle.notify_all();
+
+            for (auto& thread : m_threads)
+            {
+                thread.join();
+            }
+        }
+
+        task_scheduler& task_scheduler::global()
+        {
+            static auto scheduler = task_scheduler{ };
+
+            return scheduler;
+        }
+
+        std::size_t task_scheduler::default_workers() noexcept
+        {
+            return std::max(std::thread::hardware_concurrency(), 1u);
+        }
+
+        void task_scheduler::submit(task_t task)
+        {
+            auto& queue = *m_queues[home_queue()];
+
+            // REMARK: Count the task before it can be taken, so that the
+            //         count never drops below the number of queued tasks.
+
+            {
+                auto const lock = std::lock_guard<std::mutex>{ m_idle_lock };
+
+                ++m_queued;
+            }
+
+            {
+                auto const lock = std::lock_guard<std::mutex>{ queue.lock };
+
+                queue.tasks.push_back(std::move(task));
+            }
+
+            m_idle.notify_one();
+        }
+
+        void task_scheduler::wait_until(std::function<bool()> const& done)
+        {
+            auto const home = home_queue();
+
+            ++m_waiters;
+
+            while (not done())
+            {
+                if (run_one(home))
+                {
+                    continue;
+                }
+
+                auto lock = std::unique_lock<std::mutex>{ m_idle_lock };
+
+                m_idle.wait(lock, [this, &done]() { return m_queued > 0 or done(); });
+            }
+
+            --m_waiters;
+        }
+
+        std::size_t task_scheduler::workers() const noexcept
+        {
+            return m_threads.size();
+        }
+
+        std::size_t task_scheduler::home_queue() const noexcept
+        {
+            // REMARK: Workers keep their own tasks, other threads spread
+            //         theirs round robin.
+
+            if (current_scheduler == this)
+            {
+                return current_queue;
+            }
+
+            return m_next++ % m_queues.size();
+        }
+
+        bool task_scheduler::run_one(std::size_t const home)
+        {
+            auto task = task_t{ };
+
+            // Newest task of the home queue first, then the oldest task
+            // of any other queue.
+
+            for (auto k = std::size_t{ 0 }; k < m_queues.size() and not task; ++k)
+            {
+                auto& queue = *m_queues[(home + k) % m_queues.size()];
+
+                auto const lock = std::lock_guard<std::mutex>{ queue.lock };
+
+                if (queue.tasks.empty())
+                {
+                    continue;
+                }
+
+                if (k == 0)
+                {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                }
+                else
+                {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+            }
+
+            if (not task)
+            {
+                return false;
+            }
+
+            --m_queued;
+
+            task();
+
+            // REMARK: Wake up the threads waiting for the task to finish,
+            //         the lock orders the wake up after their check.
+
+            if (m_waiters > 0)
+            {
+                {
+                    auto const lock = std::lock_guard<std::mutex>{ m_idle_lock };
+                }
+
+                m_idle.notify_all();
+            }
+
+            return true;
+        }
+
+        void task_scheduler::work(std::size_t const index)
+        {
+            current_scheduler = this;
+            current_queue     = index;
+
+            while (true)
+            {
+                if (run_one(index))
+                {
+                    continue;
+                }
+
+                auto lock = std::unique_lock<std::mutex>{ m_idle_lock };
+
+                m_idle.wait(lock, [this]() { return m_queued > 0 or m_stop; });
+
+                if (m_stop and m_queued == 0)
+                {
+                    return;
+                }
+            }
+        }
+
+    }
+
+}
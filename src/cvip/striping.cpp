@@ -0,0 +1,172 @@
+//
+// Copyright 2022, Waldemar Villamayor-Venialbo. All Rights Reserved.
+//
+// This file is part of the AsterAID Project. See README for details.
+//
+// AsterAID is a trademark of the copyright owner. Other trademarks
+// may be the property of their respective owners.
+//
+// The content of this source code is licensed under the BSD License.
+// See LICENSE file in the project root for full license information.
+//
+
+#include <cvip/internal/ownership.hpp>
+#include <cvip/internal/striping.hpp>
+#include <cvip/profiling.hpp>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+
+
+CVIP_BEGIN_IMPLEMENTATION_DETAILS(cvip::core)
+
+    int stripe_count(matrix const& src, int const row_halo)
+    {
+        // Stripes thinner than min_stripe_rows, or than twice the halo,
+        // would spend most of the work on their halos; images smaller than
+        // min_parallel_pixels are done before the workers wake up.
+
+        static auto constexpr min_stripe_rows     = 16;
+        static auto constexpr min_parallel_pixels = std::size_t{ 64 * 1024 };
+
+        if (row_halo < 0 or src.total() < min_parallel_pixels)
+        {
+            return 1;
+        }
+
+        auto const threads = cv::getNumThreads();
+        auto const by_rows = src.rows / std::max(min_stripe_rows, 2 * row_halo);
+
+        return std::max(std::min(threads, by_rows), 1);
+    }
+
+    void apply_striped(matrix& dst, matrix& src, int const row_halo, int const stripes, bool const first,
+                       std::optional<matrix_shape> const& shape, stripe_fn const& stage)
+    {
+        // REMARK: A destination on the data of src, e.g. when applied in
+        //         place, would be written while other stripes still read
+        //         their halos from it.
+
+        if (row_halo > 0 and dst.data != nullptr and dst.data == src.data)
+        {
+            dst = matrix{ };
+        }
+
+        auto const rows = src.rows;
+        auto const cols = src.cols;
+
+        auto allocated  = std::once_flag{ };
+        auto ready      = std::atomic<bool>{ false };
+        auto error      = std::exception_ptr{ };
+        auto error_lock = std::mutex{ };
+
+        // REMARK: When the shape of the result is known in advance, dst is
+        //         created before any stripe is done, otherwise, the first
+        //         stripe done gives the result type.
+
+        if (shape)
+        {
+            if (shape->rows != rows or shape->cols != cols)
+            {
+                throw std::logic_error("basic_operator: row separable operators must preserve the image size");
+            }
+
+            dst.create(rows, cols, shape->type);
+
+            ready.store(true, std::memory_order_relaxed);
+        }
+
+        CVIP_PROFILE_STRIPES();
+
+        auto const body = [&](cv::Range const& range)
+        {
+            CVIP_PROFILE_STRIPE();
+
+            // REMARK: Stripes without halo are staged straight into their
+            //         rows of dst once it was created, the others, into a
+            //         buffer kept by the worker thread between stripes.
+
+            thread_local auto buffer = matrix{ };
+
+            for (auto k = range.start; k < range.end; ++k)
+            {
+                try
+                {
+                    auto const y0 = static_cast<int>(static_cast<long long>(rows) * k / stripes);
+                    auto const y1 = static_cast<int>(static_cast<long long>(rows) * (k + 1) / stripes);
+                    auto const a0 = std::max(y0 - row_halo, 0);
+                    auto const a1 = std::min(y1 + row_halo, rows);
+
+                    auto       in     = src.rowRange(a0, a1);
+                    auto const direct = row_halo == 0 and ready.load(std::memory_order_acquire);
+                    auto       target = direct ? dst.rowRange(y0, y1) : matrix{ };
+                    auto       out    = direct ? target : std::move(buffer);
+
+                    stage(out, in);
+
+                    if (out.rows != a1 - a0 or out.cols != cols)
+                    {
+                        throw std::logic_error("basic_operator: row separable operators must preserve the image size");
+                    }
+
+                    if (direct and out.data == target.data)
+                    {
+                        continue;
+                    }
+
+                    if (not ready.load(std::memory_order_acquire))
+                    {
+                        std::call_once(allocated, [&dst, &out, &ready, rows, cols]()
+                        {
+                            dst.create(rows, cols, out.type());
+
+                            ready.store(true, std::memory_order_release);
+                        });
+                    }
+
+                    if (out.type() != dst.type())
+                    {
+                        throw std::logic_error("basic_operator: the stripes of an image produced different types");
+                    }
+
+                    target = dst.rowRange(y0, y1);
+
+                    out.rowRange(y0 - a0, y1 - a0).copyTo(target);
+
+                    // REMARK: A result on data someone else holds, e.g. that
+                    //         of src, must not be written by a later stripe.
+
+                    if (not direct and unshared(out))
+                    {
+                        buffer = std::move(out);
+                    }
+                }
+                catch (...)
+                {
+                    auto const lock = std::lock_guard<std::mutex>{ error_lock };
+
+                    if (not error)
+                    {
+                        error = std::current_exception();
+                    }
+                }
+            }
+        };
+
+        cv::parallel_for_(cv::Range{ 0, stripes }, body, stripes);
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+
+        if (first)
+        {
+            src = matrix{ };
+        }
+    }
+
+CVIP_END_IMPLEMENTATION_DETAILS(cvip::core)
@@ -0,0 +1,210 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/allocator.hpp>
+#include <cvip/async.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <cstdint>
+#include <memory>
+
+
+using cvip::matrix;
+using cvip::core::matrix_allocator;
+
+
+namespace
+{
+
+    // Predicate adding an offset to each element into a new destination
+    //
+
+    struct offset_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<int>(y, x) = src.at<int>(y, x) + offset;
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        int offset = 0;
+    };
+
+    using offset_operator = cvip::core::basic_operator<offset_predicate>;
+
+
+    std::uintptr_t address_of(matrix const& mat)
+    {
+        return reinterpret_cast<std::uintptr_t>(mat.data);
+    }
+
+}
+
+
+// The unit test
+//
+// Allocator::BlocksAreAlignedAndReused
+//
+// test that matrix_allocator defined in src/cvip/allocator.cpp gives
+// aligned blocks, huge page aligned ones for large matrices if asked to,
+// that it reuses released blocks up to its capacity, and that it reports
+// its usage.
+//
+
+TEST(Allocator, BlocksAreAlignedAndReused)
+{
+    auto allocator = matrix_allocator{ };
+
+    auto m = matrix{ };
+
+    m.allocator = &allocator;
+
+    m.create(100, 37, CV_8UC3);
+
+    auto const block = address_of(m);
+
+    EXPECT_EQ(block % matrix_allocator::alignment, 0u);
+
+    m.release();
+    m.create(100, 37, CV_8UC3);
+
+    EXPECT_EQ(address_of(m), block);
+
+    m.release();
+
+    auto const stats = allocator.stats();
+
+    EXPECT_EQ(stats.allocations, 2u);
+    EXPECT_EQ(stats.reuses, 1u);
+    EXPECT_EQ(stats.blocks, 1u);
+    EXPECT_EQ(stats.bytes, 0u);
+    EXPECT_EQ(stats.peak, 11136u);
+    EXPECT_EQ(stats.pooled, 11136u);
+
+    allocator.clear();
+
+    EXPECT_EQ(allocator.stats().blocks, 0u);
+
+    auto huge = matrix_allocator{ true, 0 };
+
+    m.allocator = &huge;
+
+    m.create(1024, 1024, CV_32SC1);
+
+    EXPECT_EQ(address_of(m) % matrix_allocator::huge_page_size, 0u);
+
+    m.release();
+
+    EXPECT_EQ(huge.stats().blocks, 0u);
+    EXPECT_EQ(huge.stats().pooled, 0u);
+}
+
+
+// The unit test
+//
+// Allocator::PipelinesUseTheirAllocator
+//
+// test that an operator_expression allocates its intermediate results and
+// its result with its attached allocator, and that operators and the
+// applications of an async_executor use the allocator in scope, for their
+// results unless the scope leaves them to the default allocator.
+//
+
+TEST(Allocator, PipelinesUseTheirAllocator)
+{
+    auto const allocator = std::make_shared<matrix_allocator>();
+
+    auto const x = matrix(64, 64, CV_32SC1, cv::Scalar::all(0));
+
+    auto ex = offset_operator{ 1 } * offset_operator{ 2 } * offset_operator{ 3 };
+
+    ex.attach_allocator(allocator);
+
+    for (auto k = 0; k < 2; ++k)
+    {
+        auto const y = ex * x;
+
+        EXPECT_TRUE(allocator->owns(y));
+        EXPECT_EQ(y.at<int>(63, 63), 6);
+    }
+
+    EXPECT_EQ(allocator->stats().allocations, 6u);
+    EXPECT_EQ(allocator->stats().blocks, 2u);
+
+    {
+        auto const scope = cvip::core::allocator_scope{ allocator.get() };
+
+        auto const y = offset_operator{ 1 } * x;
+
+        EXPECT_TRUE(allocator->owns(y));
+    }
+
+    {
+        auto const scope = cvip::core::allocator_scope{ allocator.get(), false };
+
+        auto const allocations = allocator->stats().allocations;
+
+        auto const y = offset_operator{ 1 } * (offset_operator{ 2 } * offset_operator{ 3 }) * x;
+
+        EXPECT_FALSE(allocator->owns(y));
+        EXPECT_EQ(allocator->stats().allocations, allocations + 2);
+    }
+
+    auto const y = offset_operator{ 1 } * x;
+
+    EXPECT_FALSE(allocator->owns(y));
+
+    auto executor = cvip::core::async_executor{ 1, 0, allocator };
+
+    auto const z = cvip::core::apply_async(offset_operator{ 1 }, x, { }, executor).get();
+
+    EXPECT_TRUE(allocator->owns(z));
+}
+
+
+// The unit test
+//
+// Allocator::ResultsOutliveTheirAllocator
+//
+// test that the results of an expression remain valid, and are released
+// and reallocated safely, after the expression and its allocator are
+// destroyed.
+//
+
+TEST(Allocator, ResultsOutliveTheirAllocator)
+{
+    auto const x = matrix(64, 64, CV_32SC1, cv::Scalar::all(0));
+
+    auto y = matrix{ };
+
+    {
+        auto ex = offset_operator{ 1 } * offset_operator{ 2 };
+
+        ex.attach_allocator(std::make_shared<matrix_allocator>());
+
+        y = ex * x;
+
+        EXPECT_TRUE(ex.allocator()->owns(y));
+    }
+
+    EXPECT_EQ(y.at<int>(63, 63), 3);
+
+    auto const z = y;
+
+    y.release();
+
+    EXPECT_EQ(z.at<int>(0, 0), 3);
+
+    y.create(16, 16, CV_32SC1);
+
+    EXPECT_EQ(y.rows, 16);
+}
@@ -0,0 +1,148 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/async.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <atomic>
+#include <thread>
+#include <utility>
+
+
+using cvip::matrix;
+using cvip::core::apply_async;
+using cvip::core::async_executor;
+using cvip::core::cancel_token;
+
+
+namespace
+{
+
+    // Predicate adding an offset to each element, it counts its calls and,
+    // while the gate is closed, it waits before starting
+    //
+
+    struct offset_predicate
+    {
+        static inline auto calls = std::atomic<int>{ 0 };
+        static inline auto open  = std::atomic<bool>{ true };
+
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            while (not open)
+            {
+                std::this_thread::yield();
+            }
+
+            ++calls;
+
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<int>(y, x) = src.at<int>(y, x) + offset;
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        int offset = 0;
+    };
+
+    using offset_operator = cvip::core::basic_operator<offset_predicate>;
+
+}
+
+
+// The unit test
+//
+// AsyncApply::ResultsMatchOperatorProduct
+//
+// test that apply_async defined in src/cvip/async.cpp gives the results of
+// operator*, for operators, expressions and frozen expressions.
+//
+
+TEST(AsyncApply, ResultsMatchOperatorProduct)
+{
+    auto op = offset_operator{ 1 };
+    auto ex = offset_operator{ 20 } * offset_operator{ 300 };
+
+    auto const fx = cvip::core::frozen_expression{ ex };
+
+    auto const x = matrix(4, 4, CV_32SC1, cv::Scalar::all(0));
+
+    auto y1 = apply_async(op, x);
+    auto y2 = apply_async(ex, x);
+    auto y3 = apply_async(fx, matrix(4, 4, CV_32SC1, cv::Scalar::all(1)));
+
+    EXPECT_EQ(y1.get().at<int>(3, 3), 1);
+    EXPECT_EQ(y2.get().at<int>(3, 3), 320);
+    EXPECT_EQ(y3.get().at<int>(3, 3), 321);
+    EXPECT_EQ(x.at<int>(3, 3), 0);
+}
+
+
+// The unit test
+//
+// AsyncApply::FullExecutorPushesBack
+//
+// test that an async_executor holds no more applications in flight than
+// its capacity, and that try_submit gives up when it is full.
+//
+
+TEST(AsyncApply, FullExecutorPushesBack)
+{
+    auto executor = async_executor{ 1, 2 };
+
+    offset_predicate::open = false;
+
+    auto const x = matrix(4, 4, CV_32SC1, cv::Scalar::all(0));
+
+    auto y1 = apply_async(offset_operator{ 1 }, x, { }, executor);
+    auto y2 = apply_async(offset_operator{ 2 }, x, { }, executor);
+
+    auto y3 = executor.try_submit([]() { return matrix{ }; });
+
+    EXPECT_EQ(executor.in_flight(), 2u);
+    EXPECT_FALSE(y3.valid());
+
+    offset_predicate::open = true;
+
+    EXPECT_EQ(y1.get().at<int>(0, 0), 1);
+    EXPECT_EQ(y2.get().at<int>(0, 0), 2);
+    EXPECT_EQ(executor.in_flight(), 0u);
+}
+
+
+// The unit test
+//
+// AsyncApply::CancelledWorkNeverRuns
+//
+// test that an application cancelled before it starts is skipped, and
+// that its future throws cancelled_error.
+//
+
+TEST(AsyncApply, CancelledWorkNeverRuns)
+{
+    auto executor = async_executor{ 1 };
+
+    offset_predicate::open  = false;
+    offset_predicate::calls = 0;
+
+    auto const x = matrix(4, 4, CV_32SC1, cv::Scalar::all(0));
+
+    auto token = cancel_token{ };
+
+    auto y1 = apply_async(offset_operator{ 1 }, x, { }, executor);
+    auto y2 = apply_async(offset_operator{ 2 }, x, token, executor);
+
+    token.cancel();
+
+    offset_predicate::open = true;
+
+    EXPECT_EQ(y1.get().at<int>(0, 0), 1);
+    EXPECT_THROW(y2.get(), cvip::core::cancelled_error);
+    EXPECT_EQ(offset_predicate::calls, 1);
+}
@@ -0,0 +1,145 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/batch.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+
+using cvip::matrix;
+
+
+// A stateful predicate, it adds its offset and counts the images it has seen
+// in its own (cloned) state, and the total count in a shared counter.
+//
+
+struct offset_predicate
+{
+    offset_predicate(int offset, std::atomic<int>* calls) : m_offset{ offset }, m_calls{ calls }
+    {
+        // NOOP
+    }
+
+    void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+    {
+        if (src.at<int>(0, 0) < 0)
+        {
+            throw std::runtime_error("negative input");
+        }
+
+        ++m_seen;
+        ++*m_calls;
+
+        src.copyTo(dst);
+        dst.at<int>(0, 0) += m_offset;
+        src = matrix{ };
+    }
+
+    int m_offset;
+    int m_seen = 0;
+    std::atomic<int>* m_calls;
+};
+
+using offset_operator = cvip::core::basic_operator<offset_predicate>;
+
+
+struct offset_operator_fake : public cvip::core::base_operator< offset_operator_fake >
+{
+    virtual void apply(matrix& dst, matrix& src, bool const first [[maybe_unused]]) override
+    {
+        src.copyTo(dst);
+        dst.at<int>(0, 0) *= 2;
+        src = matrix{ };
+    }
+};
+
+
+static std::vector<matrix> make_images(int count)
+{
+    auto images = std::vector<matrix>{ };
+
+    for (auto i = 0; i < count; ++i)
+    {
+        images.emplace_back(1, 1, CV_32SC1, cv::Scalar::all(i));
+    }
+
+    return images;
+}
+
+
+// The unit tests
+//
+// Batch::OperatorResultsKeepInputOrder,
+//
+// Batch::ExpressionResultsKeepInputOrder
+//
+// and
+//
+// Batch::FirstExceptionIsRethrown
+//
+// test the batch_apply functions defined in src/cvip/batch.cpp for both
+// execution models.
+//
+
+TEST(Batch, OperatorResultsKeepInputOrder)
+{
+    auto calls = std::atomic<int>{ 0 };
+
+    auto op = offset_operator{ 10, &calls };
+    auto xs = make_images(64);
+
+    for (auto const model : { cvip::execution_model::parallel, cvip::execution_model::sequential })
+    {
+        auto ys = std::vector<matrix>{ };
+
+        cvip::core::batch_apply(op, xs.begin(), xs.end(), std::back_inserter(ys), model);
+
+        ASSERT_EQ(ys.size(), xs.size());
+
+        for (auto i = 0; i < static_cast<int>(ys.size()); ++i)
+        {
+            EXPECT_EQ(ys[i].at<int>(0, 0), i + 10);
+        }
+    }
+
+    EXPECT_EQ(calls, 128);
+}
+
+
+TEST(Batch, ExpressionResultsKeepInputOrder)
+{
+    auto calls = std::atomic<int>{ 0 };
+
+    auto op1 = offset_operator{ 1, &calls };
+    auto op2 = offset_operator_fake{ };
+    auto xs  = make_images(64);
+
+    auto const ex = op2 * op1;
+
+    auto ys = cvip::core::batch_apply(ex, xs);
+
+    ASSERT_EQ(ys.size(), xs.size());
+
+    for (auto i = 0; i < static_cast<int>(ys.size()); ++i)
+    {
+        EXPECT_EQ(ys[i].at<int>(0, 0), (i + 1) * 2);
+        EXPECT_EQ(xs[i].at<int>(0, 0), i);
+    }
+
+    EXPECT_EQ(calls, 64);
+}
+
+
+TEST(Batch, FirstExceptionIsRethrown)
+{
+    auto calls = std::atomic<int>{ 0 };
+
+    auto op = offset_operator{ 1, &calls };
+    auto xs = make_images(64);
+
+    xs[17].at<int>(0, 0) = -1;
+
+    EXPECT_THROW(cvip::core::batch_apply(op, xs), std::runtime_error);
+}
@@ -0,0 +1,193 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/buffer_pool.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+
+
+using cvip::matrix;
+
+
+// A predicate that writes its result into the dst buffer it receives, if it
+// has the appropriate size, as the predicates in the README do.
+//
+
+struct negate_predicate
+{
+    void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+    {
+        dst.create(src.rows, src.cols, src.type());
+
+        for (auto y = 0; y < src.rows; ++y)
+        {
+            for (auto x = 0; x < src.cols; ++x)
+            {
+                dst.at<int>(y, x) = -src.at<int>(y, x);
+            }
+        }
+
+        src = matrix{ };
+    }
+};
+
+struct first_dst_predicate
+{
+    static inline auto nonempty = 0;
+
+    void do_apply(matrix& dst, matrix& src, bool const first)
+    {
+        nonempty += first and not dst.empty() ? 1 : 0;
+
+        src.copyTo(dst);
+        src = matrix{ };
+    }
+};
+
+struct negate_operator_fake : public cvip::core::base_operator< negate_operator_fake >
+{
+    virtual void apply(matrix& dst, matrix& src, bool const first) override
+    {
+        m_pr.do_apply(dst, src, first);
+    }
+
+    negate_predicate m_pr;
+};
+
+
+// The unit tests
+//
+// BufferPool::ReleasedBufferIsRecycled,
+//
+// and
+//
+// BufferPool::CapacityIsHonoured
+//
+// test the buffer_pool class defined in src/cvip/buffer_pool.cpp.
+//
+
+TEST(BufferPool, ReleasedBufferIsRecycled)
+{
+    auto pool = cvip::core::buffer_pool{ };
+
+    EXPECT_EQ(pool.capacity(), cvip::core::buffer_pool::default_capacity);
+
+    auto a = pool.acquire(4, 4, CV_32SC1);
+    auto b = pool.acquire(4, 4, CV_32SC1);
+
+    EXPECT_NE(a.data, b.data);
+
+    auto const data = a.data;
+
+    a.release();
+
+    auto c = pool.acquire(4, 4, CV_32SC1);
+    auto d = pool.acquire(4, 4, CV_8UC1);
+
+    EXPECT_EQ(c.data, data);
+
+    auto const stats = pool.stats();
+
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 3u);
+    EXPECT_EQ(stats.buffers, 3u);
+    EXPECT_EQ(stats.bytes, 2u * 64u + 16u);
+}
+
+
+TEST(BufferPool, CapacityIsHonoured)
+{
+    auto pool = cvip::core::buffer_pool{ 100 };
+
+    auto a = pool.acquire(4, 4, CV_32SC1);
+    auto b = pool.acquire(4, 4, CV_32SC1);
+
+    EXPECT_EQ(pool.stats().bytes, 64u);
+
+    a.release();
+
+    auto c = pool.acquire(2, 2, CV_32SC1);
+    auto d = pool.acquire(4, 4, CV_32FC1);
+
+    auto const stats = pool.stats();
+
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.bytes, 80u);
+    EXPECT_LE(stats.peak, 100u);
+}
+
+
+// The unit test
+//
+// BufferPool::SteadyStateDoesNotAllocate
+//
+// test that operator_expression::apply defined in src/cvip/expression.cpp
+// takes every buffer but the result of the first operator from the attached
+// pool once it knows the shapes the operators produce.
+//
+
+TEST(BufferPool, SteadyStateDoesNotAllocate)
+{
+    auto op1 = negate_operator_fake{ };
+    auto op2 = negate_operator_fake{ };
+    auto op3 = negate_operator_fake{ };
+    auto x   = matrix(8, 8, CV_32SC1, cv::Scalar::all(3));
+
+    auto ex = op3 * op2 * op1;
+
+    ex.enable_pooling();
+
+    for (auto i = 0; i < 4; ++i)
+    {
+        auto y = ex * x;
+
+        EXPECT_EQ(y.at<int>(7, 7), -3);
+    }
+
+    auto const warm = ex.pool()->stats();
+
+    for (auto i = 0; i < 16; ++i)
+    {
+        auto y = ex * x;
+
+        EXPECT_EQ(y.at<int>(7, 7), -3);
+    }
+
+    auto const stats = ex.pool()->stats();
+
+    EXPECT_EQ(stats.misses, warm.misses);
+    EXPECT_GT(stats.hits, warm.hits);
+    EXPECT_EQ(x.at<int>(0, 0), 3);
+}
+
+
+// The unit test
+//
+// BufferPool::FirstStageGetsAnEmptyDestination
+//
+// test that operator_expression::apply recycles buffers only for the
+// operators after the first, which gets an empty dst as i_operator::apply
+// promises.
+//
+
+TEST(BufferPool, FirstStageGetsAnEmptyDestination)
+{
+    using first_dst_operator = cvip::core::basic_operator<first_dst_predicate>;
+
+    auto op1 = first_dst_operator{ };
+    auto op2 = negate_operator_fake{ };
+    auto x   = matrix(8, 8, CV_32SC1, cv::Scalar::all(3));
+
+    auto ex = op2 * op1;
+
+    ex.enable_pooling();
+
+    for (auto i = 0; i < 4; ++i)
+    {
+        auto y = ex * x;
+
+        EXPECT_EQ(y.at<int>(7, 7), -3);
+    }
+
+    EXPECT_EQ(first_dst_predicate::nonempty, 0);
+    EXPECT_GT(ex.pool()->stats().hits, 0u);
+}
@@ -0,0 +1,155 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+
+using cvip::matrix;
+
+
+namespace
+{
+
+    // Predicate that can be retuned
+    //
+
+    struct offset_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<int>(y, x) = 10 * src.at<int>(y, x) + offset;
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        void reset(int const value)
+        {
+            offset = value;
+        }
+
+        int offset = 0;
+    };
+
+    using offset_operator = cvip::core::basic_operator<offset_predicate>;
+
+
+    // Number of allocations made by the calling thread
+    //
+
+    thread_local auto t_allocations = std::size_t{ 0 };
+
+}
+
+
+void* operator new(std::size_t size)
+{
+    ++t_allocations;
+
+    if (auto* const memory = std::malloc(size > 0 ? size : 1))
+    {
+        return memory;
+    }
+
+    throw std::bad_alloc{ };
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t size [[maybe_unused]]) noexcept
+{
+    std::free(memory);
+}
+
+
+// The unit test
+//
+// ChainStorage::CopiesDoNotShareTheChain
+//
+// test that extending a copy of an operator_expression, declared in
+// include/cvip/expression.hpp, leaves the original chain as it was.
+//
+
+TEST(ChainStorage, CopiesDoNotShareTheChain)
+{
+    auto ex = offset_operator{ 2 } * offset_operator{ 1 };
+
+    auto copy = ex;
+
+    auto longer = std::move(copy) * offset_operator{ 3 };
+
+    auto const x = matrix(2, 2, CV_32SC1, cv::Scalar::all(0));
+
+    EXPECT_EQ((ex * x).at<int>(1, 1), 12);
+    EXPECT_EQ((longer * x).at<int>(1, 1), 312);
+}
+
+
+// The unit test
+//
+// ChainStorage::OperatorsAreCopiedOnWrite
+//
+// test that retuning a stage of a copy of an operator_expression does not
+// retune the operator of the original, which it shared until then.
+//
+
+TEST(ChainStorage, OperatorsAreCopiedOnWrite)
+{
+    auto ex = offset_operator{ 2 } * offset_operator{ 1 };
+
+    auto copy = ex;
+
+    copy.stage<offset_operator>(1)(5);
+
+    auto const x = matrix(2, 2, CV_32SC1, cv::Scalar::all(0));
+
+    EXPECT_EQ((ex * x).at<int>(1, 1), 12);
+    EXPECT_EQ((copy * x).at<int>(1, 1), 15);
+    EXPECT_EQ(ex.stage<offset_operator>(1).predicate().offset, 2);
+}
+
+
+// The unit test
+//
+// ChainStorage::ShortChainsAllocateOnce
+//
+// test that building a short operator_expression, with its operators and
+// their table, takes a single allocation, and that copying it takes none.
+//
+
+TEST(ChainStorage, ShortChainsAllocateOnce)
+{
+    auto const op1 = offset_operator{ 1 };
+    auto const op2 = offset_operator{ 2 };
+    auto const op3 = offset_operator{ 3 };
+
+    auto const before = t_allocations;
+
+    auto ex = op3 * op2 * op1;
+
+    auto const built = t_allocations;
+
+    auto copy = ex;
+
+    EXPECT_EQ(built - before, 1u);
+    EXPECT_EQ(t_allocations, built);
+
+    auto const x = matrix(2, 2, CV_32SC1, cv::Scalar::all(0));
+
+    EXPECT_EQ((copy * x).at<int>(1, 1), 123);
+}
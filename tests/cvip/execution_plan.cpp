@@ -0,0 +1,309 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/execution_plan.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+
+using cvip::matrix;
+
+
+namespace
+{
+
+    // Pointwise predicate adding an offset, with an elementwise kernel
+    //
+
+    struct add_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first)
+        {
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                map(src.ptr<cvip::upix_t>(y), dst.ptr<cvip::upix_t>(y), src.cols);
+            }
+
+            if (first)
+            {
+                src = matrix{ };
+            }
+        }
+
+        void map(cvip::upix_t const* src, cvip::upix_t* dst, int const count) const
+        {
+            for (auto i = 0; i < count; ++i)
+            {
+                dst[i] = static_cast<cvip::upix_t>(src[i] + offset);
+            }
+        }
+
+        void reset(int const value)
+        {
+            offset = value;
+        }
+
+        int offset = 0;
+    };
+
+    // Local predicate, the maximum over a 3x3 neighbourhood, borders are
+    // replicated
+    //
+
+    struct dilate_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    auto value = 0;
+
+                    for (auto v = y - 1; v <= y + 1; ++v)
+                    {
+                        for (auto u = x - 1; u <= x + 1; ++u)
+                        {
+                            auto const r = std::clamp(v, 0, src.rows - 1);
+                            auto const c = std::clamp(u, 0, src.cols - 1);
+
+                            value = std::max(value, static_cast<int>(src.at<cvip::upix_t>(r, c)));
+                        }
+                    }
+
+                    dst.at<cvip::upix_t>(y, x) = static_cast<cvip::upix_t>(value);
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        int halo() const
+        {
+            return 1;
+        }
+    };
+
+    // The same, declaring the shape of its output, it counts the times it
+    // was handed a destination as the first stage
+    //
+
+    struct shaped_dilate_predicate : public dilate_predicate
+    {
+        static inline auto nonempty = 0;
+
+        void do_apply(matrix& dst, matrix& src, bool const first)
+        {
+            nonempty += first and not dst.empty() ? 1 : 0;
+
+            dilate_predicate::do_apply(dst, src, first);
+        }
+
+        cvip::matrix_shape output_shape(cvip::matrix_shape const& input) const
+        {
+            return input;
+        }
+    };
+
+    // Predicate adding to each element its left neighbour
+    //
+
+    struct neighbour_sum_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    auto const left = x > 0 ? src.at<cvip::upix_t>(y, x - 1) : 0;
+
+                    dst.at<cvip::upix_t>(y, x) = static_cast<cvip::upix_t>(src.at<cvip::upix_t>(y, x) + left);
+                }
+            }
+
+            src = matrix{ };
+        }
+    };
+
+    using add_operator           = cvip::core::basic_operator<add_predicate>;
+    using dilate_operator        = cvip::core::basic_operator<dilate_predicate>;
+    using shaped_dilate_operator = cvip::core::basic_operator<shaped_dilate_predicate>;
+    using neighbour_sum_operator = cvip::core::basic_operator<neighbour_sum_predicate>;
+
+
+    matrix frame(int const rows, int const cols, int const seed)
+    {
+        auto image = matrix(rows, cols, CV_8UC1);
+
+        for (auto y = 0; y < rows; ++y)
+        {
+            for (auto x = 0; x < cols; ++x)
+            {
+                image.at<cvip::upix_t>(y, x) = static_cast<cvip::upix_t>((y * 7 + x * 3 + seed) % 101);
+            }
+        }
+
+        return image;
+    }
+
+
+    int mismatches(matrix const& lhs, matrix const& rhs)
+    {
+        auto count = 0;
+
+        for (auto y = 0; y < lhs.rows; ++y)
+        {
+            for (auto x = 0; x < lhs.cols; ++x)
+            {
+                count += lhs.at<cvip::upix_t>(y, x) != rhs.at<cvip::upix_t>(y, x) ? 1 : 0;
+            }
+        }
+
+        return count;
+    }
+
+}
+
+
+// The unit test
+//
+// ExecutionPlan::PlanMatchesExpression
+//
+// test that an execution_plan, defined in src/cvip/execution_plan.cpp,
+// fuses consecutive pointwise operators into a single step, gives the
+// results of the expression it was compiled from, also when the shape of
+// an intermediate result is unknown, and rejects images of another shape.
+//
+
+TEST(ExecutionPlan, PlanMatchesExpression)
+{
+    auto ex = add_operator{ 1 } * add_operator{ 2 } * shaped_dilate_operator{ } * add_operator{ 3 };
+    auto un = add_operator{ 1 } * add_operator{ 2 } * dilate_operator{ } * add_operator{ 3 };
+
+    auto plan = ex.compile({ 40, 30, CV_8UC1 });
+    auto late = un.compile({ 40, 30, CV_8UC1 });
+
+    EXPECT_EQ(plan.steps(), 3u);
+    EXPECT_EQ(plan.tiles(), 1u);
+
+    for (auto seed = 0; seed < 3; ++seed)
+    {
+        auto const x = frame(40, 30, seed);
+
+        EXPECT_EQ(mismatches(plan * x, ex * x), 0);
+        EXPECT_EQ(mismatches(late * x, ex * x), 0);
+    }
+
+    EXPECT_THROW(plan * frame(30, 40, 0), std::invalid_argument);
+}
+
+
+// The unit test
+//
+// ExecutionPlan::TiledPlanMatchesExpression
+//
+// test that a plan compiled from an expression with tiling enabled splits
+// the image into tiles, and gives the result of the untiled expression.
+//
+
+TEST(ExecutionPlan, TiledPlanMatchesExpression)
+{
+    auto ex = dilate_operator{ } * add_operator{ 5 } * dilate_operator{ };
+
+    auto tiled = ex;
+
+    tiled.enable_tiling(4 * 1024);
+
+    auto plan = tiled.compile({ 150, 200, CV_8UC1 });
+
+    EXPECT_GT(plan.tiles(), 1u);
+
+    auto const x = frame(150, 200, 1);
+
+    EXPECT_EQ(mismatches(plan * x, ex * x), 0);
+}
+
+
+// The unit test
+//
+// ExecutionPlan::PlanKeepsCompiledOperators
+//
+// test that retuning an expression after compiling it does not change the
+// plan.
+//
+
+TEST(ExecutionPlan, PlanKeepsCompiledOperators)
+{
+    auto ex = add_operator{ 1 } * dilate_operator{ };
+
+    auto plan = ex.compile({ 4, 4, CV_8UC1 });
+
+    ex.stage<add_operator>(1)(10);
+
+    auto const x = matrix(4, 4, CV_8UC1, cv::Scalar::all(0));
+
+    EXPECT_EQ((plan * x).at<cvip::upix_t>(0, 0), 1);
+    EXPECT_EQ((ex * x).at<cvip::upix_t>(0, 0), 10);
+}
+
+
+// The unit test
+//
+// ExecutionPlan::NextStepDoesNotWriteItsSource
+//
+// test that, after a fused step working in place, a step that does not
+// work in place is not given its own source as target.
+//
+
+TEST(ExecutionPlan, NextStepDoesNotWriteItsSource)
+{
+    auto ex = neighbour_sum_operator{ } * add_operator{ 1 } * add_operator{ 1 } * dilate_operator{ };
+
+    auto plan = ex.compile({ 1, 4, CV_8UC1 });
+
+    auto const x = matrix(1, 4, CV_8UC1, cv::Scalar::all(10));
+
+    for (auto const& y : { plan * x, ex * x })
+    {
+        EXPECT_EQ(y.at<cvip::upix_t>(0, 0), 12);
+        EXPECT_EQ(y.at<cvip::upix_t>(0, 1), 24);
+        EXPECT_EQ(y.at<cvip::upix_t>(0, 3), 24);
+    }
+
+    EXPECT_EQ(x.at<cvip::upix_t>(0, 3), 10);
+}
+
+
+// The unit test
+//
+// ExecutionPlan::FirstStepGetsAnEmptyDestination
+//
+// test that the first step of a plan is not given a scratch buffer as
+// destination, even when the shape of its result is known.
+//
+
+TEST(ExecutionPlan, FirstStepGetsAnEmptyDestination)
+{
+    auto ex = add_operator{ 1 } * shaped_dilate_operator{ };
+
+    auto plan = ex.compile({ 8, 8, CV_8UC1 });
+
+    shaped_dilate_predicate::nonempty = 0;
+
+    for (auto seed = 0; seed < 3; ++seed)
+    {
+        auto const x = frame(8, 8, seed);
+
+        EXPECT_EQ(mismatches(plan * x, ex * x), 0);
+    }
+
+    EXPECT_EQ(shaped_dilate_predicate::nonempty, 0);
+}
@@ -0,0 +1,123 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/frozen.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+using cvip::matrix;
+using cvip::core::frozen_expression;
+
+
+namespace
+{
+
+    // Predicate that can be retuned, it does not modify itself when applied
+    //
+
+    struct offset_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<int>(y, x) = 10 * src.at<int>(y, x) + offset;
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        void reset(int const value)
+        {
+            offset = value;
+        }
+
+        int offset = 0;
+    };
+
+    using offset_operator = cvip::core::basic_operator<offset_predicate>;
+
+}
+
+
+// The unit test
+//
+// FrozenExpression::ConcurrentApplicationsAgree
+//
+// test that a frozen_expression, defined in src/cvip/frozen.cpp, applied
+// from several threads at once gives the same results as applied from a
+// single one, and that it creates no more contexts than threads.
+//
+
+TEST(FrozenExpression, ConcurrentApplicationsAgree)
+{
+    auto const fx = frozen_expression{ offset_operator{ 3 } * offset_operator{ 2 } * offset_operator{ 1 } };
+
+    auto constexpr threads = 8;
+
+    auto failures = std::atomic<int>{ 0 };
+
+    auto workers = std::vector<std::thread>{ };
+
+    for (auto t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&fx, &failures, t]()
+        {
+            for (auto k = 0; k < 50; ++k)
+            {
+                auto const y = fx * matrix(16, 16, CV_32SC1, cv::Scalar::all(t));
+
+                if (y.at<int>(15, 15) != 1000 * t + 123)
+                {
+                    ++failures;
+                }
+            }
+        });
+    }
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    EXPECT_EQ(failures, 0);
+    EXPECT_GE(fx.contexts(), 1u);
+    EXPECT_LE(fx.contexts(), static_cast<std::size_t>(threads));
+}
+
+
+// The unit test
+//
+// FrozenExpression::ContextsAreReused
+//
+// test that sequential applications of a frozen_expression reuse a single
+// context, and that retuning the expression it was made from does not
+// affect it.
+//
+
+TEST(FrozenExpression, ContextsAreReused)
+{
+    auto ex = offset_operator{ 2 } * offset_operator{ 1 };
+
+    auto const fx = frozen_expression{ ex };
+
+    ex.stage<offset_operator>(1)(5);
+
+    auto const x = matrix(4, 4, CV_32SC1, cv::Scalar::all(0));
+
+    for (auto k = 0; k < 3; ++k)
+    {
+        EXPECT_EQ((fx * x).at<int>(3, 3), 12);
+    }
+
+    EXPECT_EQ(fx.contexts(), 1u);
+    EXPECT_EQ((ex * x).at<int>(3, 3), 15);
+}
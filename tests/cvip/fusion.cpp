@@ -0,0 +1,236 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <algorithm>
+
+
+using cvip::matrix;
+
+
+// Pointwise predicates with an elementwise kernel; do_apply uses the same
+// kernel on the whole image, and counts how many times it was called.
+//
+
+template<typename Kernel>
+struct pointwise_predicate
+{
+    static inline auto calls = 0;
+
+    void do_apply(matrix& dst, matrix& src, bool const first)
+    {
+        ++calls;
+
+        dst.create(src.rows, src.cols, src.type());
+
+        for (auto y = 0; y < src.rows; ++y)
+        {
+            m_kernel.map(src.ptr<cvip::upix_t>(y), dst.ptr<cvip::upix_t>(y), src.cols);
+        }
+
+        if (first)
+        {
+            src = matrix{ };
+        }
+    }
+
+    void map(cvip::upix_t const* src, cvip::upix_t* dst, int const count) const
+    {
+        m_kernel.map(src, dst, count);
+    }
+
+    Kernel m_kernel = { };
+};
+
+struct invert_kernel
+{
+    void map(cvip::upix_t const* src, cvip::upix_t* dst, int const count) const
+    {
+        for (auto i = 0; i < count; ++i)
+        {
+            dst[i] = static_cast<cvip::upix_t>(255 - src[i]);
+        }
+    }
+};
+
+struct halve_kernel
+{
+    void map(cvip::upix_t const* src, cvip::upix_t* dst, int const count) const
+    {
+        for (auto i = 0; i < count; ++i)
+        {
+            dst[i] = static_cast<cvip::upix_t>(src[i] / 2);
+        }
+    }
+};
+
+struct threshold_kernel
+{
+    void map(cvip::upix_t const* src, cvip::upix_t* dst, int const count) const
+    {
+        for (auto i = 0; i < count; ++i)
+        {
+            dst[i] = static_cast<cvip::upix_t>(src[i] > 64 ? 255 : 0);
+        }
+    }
+};
+
+using invert_operator    = cvip::core::basic_operator<pointwise_predicate<invert_kernel>>;
+using halve_operator     = cvip::core::basic_operator<pointwise_predicate<halve_kernel>>;
+using threshold_operator = cvip::core::basic_operator<pointwise_predicate<threshold_kernel>>;
+
+
+// A predicate with no kernel
+//
+
+struct transpose_predicate
+{
+    static inline auto calls = 0;
+
+    void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+    {
+        ++calls;
+
+        dst.create(src.cols, src.rows, src.type());
+
+        for (auto y = 0; y < src.rows; ++y)
+        {
+            for (auto x = 0; x < src.cols; ++x)
+            {
+                dst.at<cvip::upix_t>(x, y) = src.at<cvip::upix_t>(y, x);
+            }
+        }
+
+        src = matrix{ };
+    }
+};
+
+using transpose_operator = cvip::core::basic_operator<transpose_predicate>;
+
+
+static void reset_calls()
+{
+    pointwise_predicate<invert_kernel>::calls    = 0;
+    pointwise_predicate<halve_kernel>::calls     = 0;
+    pointwise_predicate<threshold_kernel>::calls = 0;
+    transpose_predicate::calls                   = 0;
+}
+
+static int pointwise_calls()
+{
+    return pointwise_predicate<invert_kernel>::calls
+         + pointwise_predicate<halve_kernel>::calls
+         + pointwise_predicate<threshold_kernel>::calls;
+}
+
+
+// The unit tests
+//
+// Fusion::PointwiseRunIsFused,
+//
+// and
+//
+// Fusion::RunsAreSplitByOtherOperators
+//
+// test that operator_expression::apply defined in src/cvip/expression.cpp,
+// and static_expression::apply defined in static_expression.inl, fuse runs
+// of pointwise operators, without calling their do_apply, and  that  the
+// result is the same as applying the operators one at a time.
+//
+
+TEST(Fusion, PointwiseRunIsFused)
+{
+    auto inv = invert_operator{ };
+    auto hlv = halve_operator{ };
+    auto thr = threshold_operator{ };
+
+    auto const x = make_ramp(37, 41);
+    auto const r = x(cvip::rect{ 3, 5, 29, 23 });
+
+    auto const expected_x = thr * (hlv * (inv * x));
+    auto const expected_r = thr * (hlv * (inv * r));
+
+    auto sx = cvip::core::make_static(thr, hlv, inv);
+    auto ex = thr * hlv * inv;
+
+    reset_calls();
+
+    auto const y1 = sx * x;
+    auto const z1 = sx * r;
+    auto const y2 = ex * x;
+    auto const z2 = ex * r;
+
+    EXPECT_EQ(pointwise_calls(), 0);
+    EXPECT_EQ(cv::norm(y1, expected_x, cv::NORM_INF), 0.0);
+    EXPECT_EQ(cv::norm(z1, expected_r, cv::NORM_INF), 0.0);
+    EXPECT_EQ(cv::norm(y2, expected_x, cv::NORM_INF), 0.0);
+    EXPECT_EQ(cv::norm(z2, expected_r, cv::NORM_INF), 0.0);
+    EXPECT_EQ(cv::norm(x, make_ramp(37, 41), cv::NORM_INF), 0.0);
+}
+
+
+TEST(Fusion, RunsAreSplitByOtherOperators)
+{
+    auto inv = invert_operator{ };
+    auto hlv = halve_operator{ };
+    auto thr = threshold_operator{ };
+    auto trn = transpose_operator{ };
+
+    auto const x = make_ramp(19, 11);
+
+    auto const expected = thr * (trn * (hlv * (trn * (hlv * (inv * x)))));
+
+    auto ex = thr * trn * hlv * trn * hlv * inv;
+
+    reset_calls();
+
+    auto const y = ex * x;
+
+    EXPECT_EQ(transpose_predicate::calls, 2);
+    EXPECT_EQ(pointwise_predicate<invert_kernel>::calls, 0);
+    EXPECT_EQ(pointwise_predicate<halve_kernel>::calls, 1);
+    EXPECT_EQ(pointwise_predicate<threshold_kernel>::calls, 1);
+    EXPECT_EQ(cv::norm(y, expected, cv::NORM_INF), 0.0);
+}
+
+
+// The unit test
+//
+// Fusion::UnsupportedDepthIsNotFused
+//
+// test that operators are applied one at a time on images of a depth their
+// kernels do not support.
+//
+
+TEST(Fusion, UnsupportedDepthIsNotFused)
+{
+    struct copy_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            ++calls;
+
+            src.copyTo(dst);
+            src = matrix{ };
+        }
+
+        void map(cvip::upix_t const* src, cvip::upix_t* dst, int const count) const
+        {
+            std::copy(src, src + count, dst);
+        }
+
+        int& calls;
+    };
+
+    auto calls = 0;
+
+    auto op = cvip::core::basic_operator<copy_predicate>{ calls };
+
+    auto const x = matrix(4, 4, CV_32FC1, cv::Scalar::all(2));
+
+    auto const y = op * op * op * x;
+
+    EXPECT_EQ(calls, 3);
+    EXPECT_EQ(y.at<float>(3, 3), 2.0f);
+}
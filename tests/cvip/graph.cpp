@@ -0,0 +1,166 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/graph.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+
+using cvip::matrix;
+using cvip::core::operator_graph;
+
+
+namespace
+{
+
+    // Predicate adding an offset to each element, it counts its calls and
+    // records whether it was applied in place
+    //
+
+    struct offset_predicate
+    {
+        static inline auto calls   = std::atomic<int>{ 0 };
+        static inline auto aliased = std::atomic<int>{ 0 };
+
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            ++calls;
+
+            if (dst.data == src.data)
+            {
+                ++aliased;
+            }
+
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<int>(y, x) = src.at<int>(y, x) + offset;
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        static constexpr bool in_place()
+        {
+            return true;
+        }
+
+        int offset = 0;
+    };
+
+    using offset_operator = cvip::core::basic_operator<offset_predicate>;
+
+
+    matrix sum_of(std::vector<matrix> const& inputs)
+    {
+        auto sum = matrix(inputs.front().rows, inputs.front().cols, CV_32SC1, cv::Scalar::all(0));
+
+        for (auto const& input : inputs)
+        {
+            for (auto y = 0; y < sum.rows; ++y)
+            {
+                for (auto x = 0; x < sum.cols; ++x)
+                {
+                    sum.at<int>(y, x) += input.at<int>(y, x);
+                }
+            }
+        }
+
+        return sum;
+    }
+
+}
+
+
+// The unit test
+//
+// OperatorGraph::SharedNodesAreComputedOnce
+//
+// test that operator_graph::apply defined in src/cvip/graph.cpp computes
+// a node feeding several consumers once, and that the parallel and the
+// sequential execution models give the same results.
+//
+
+TEST(OperatorGraph, SharedNodesAreComputedOnce)
+{
+    auto graph = operator_graph{ };
+
+    auto const pre = graph.add(offset_operator{ 1 }, operator_graph::input);
+    auto const a   = graph.add(offset_operator{ 10 }, pre);
+    auto const b   = graph.add(offset_operator{ 100 } * offset_operator{ 1000 }, pre);
+    auto const c   = graph.combine(sum_of, { a, b });
+
+    auto const x = matrix(8, 8, CV_32SC1, cv::Scalar::all(0));
+
+    for (auto const model : { cvip::execution_model::parallel, cvip::execution_model::sequential })
+    {
+        offset_predicate::calls = 0;
+
+        auto const results = graph.apply(x, { c, a }, model);
+
+        EXPECT_EQ(offset_predicate::calls, 4);
+        EXPECT_EQ(results[0].at<int>(7, 7), 1112);
+        EXPECT_EQ(results[1].at<int>(7, 7), 11);
+        EXPECT_EQ(x.at<int>(7, 7), 0);
+    }
+}
+
+
+// The unit test
+//
+// OperatorGraph::LastConsumerTakesTheResultOver
+//
+// test that an intermediate result with a single consumer is handed over
+// to it, so that it is overwritten in place, while the results the caller
+// asked for are not.
+//
+
+TEST(OperatorGraph, LastConsumerTakesTheResultOver)
+{
+    auto graph = operator_graph{ };
+
+    auto const a = graph.add(offset_operator{ 1 }, operator_graph::input);
+    auto const b = graph.add(offset_operator{ 2 }, a);
+    auto const c = graph.add(offset_operator{ 3 }, b);
+    auto const d = graph.add(offset_operator{ 4 }, c);
+
+    auto const x = matrix(8, 8, CV_32SC1, cv::Scalar::all(0));
+
+    offset_predicate::aliased = 0;
+
+    auto const results = graph.apply(x, { d, b });
+
+    EXPECT_EQ(offset_predicate::aliased, 2);
+    EXPECT_EQ(results[0].at<int>(0, 0), 10);
+    EXPECT_EQ(results[1].at<int>(0, 0), 3);
+}
+
+
+// The unit test
+//
+// OperatorGraph::ErrorsAreRethrown
+//
+// test that an exception thrown by a node is rethrown by apply, and that
+// the nodes that depend on it are skipped.
+//
+
+TEST(OperatorGraph, ErrorsAreRethrown)
+{
+    auto graph = operator_graph{ };
+
+    auto const a = graph.add(offset_operator{ 1 }, operator_graph::input);
+    auto const b = graph.combine([](std::vector<matrix> const&) -> matrix { throw std::runtime_error("failed"); }, { a });
+    auto const c = graph.add(offset_operator{ 1 }, b);
+
+    offset_predicate::calls = 0;
+
+    EXPECT_THROW(graph.apply(matrix(4, 4, CV_32SC1), c), std::runtime_error);
+    EXPECT_EQ(offset_predicate::calls, 1);
+    EXPECT_THROW(graph.apply(matrix(4, 4, CV_32SC1), 7), std::out_of_range);
+}
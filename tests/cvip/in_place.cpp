@@ -0,0 +1,188 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <vector>
+
+
+using cvip::matrix;
+
+
+namespace
+{
+
+    // Predicate that records whether it was given its source as target
+    //
+    template<bool InPlace>
+    struct increment_predicate
+    {
+        static inline auto aliased = std::vector<bool>{ };
+
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            aliased.push_back(not dst.empty() and dst.data == src.data);
+
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<int>(y, x) = src.at<int>(y, x) + 1;
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        static constexpr bool in_place()
+        {
+            return InPlace;
+        }
+    };
+
+    // In-place predicate adding one to each element, working on its source
+    // it leaves it in place, as the result
+    //
+
+    struct shared_increment_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<int>(y, x) = src.at<int>(y, x) + 1;
+                }
+            }
+
+            if (dst.data != src.data)
+            {
+                src = matrix{ };
+            }
+        }
+
+        static constexpr bool in_place()
+        {
+            return true;
+        }
+    };
+
+    // Predicate adding to each element its left neighbour, not in place
+    //
+
+    struct neighbour_sum_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<int>(y, x) = src.at<int>(y, x) + (x > 0 ? src.at<int>(y, x - 1) : 0);
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        int halo() const
+        {
+            return 1;
+        }
+    };
+
+    using in_place_operator     = cvip::core::basic_operator<increment_predicate<true>>;
+    using out_of_place_operator = cvip::core::basic_operator<increment_predicate<false>>;
+    using shared_increment_operator = cvip::core::basic_operator<shared_increment_predicate>;
+    using neighbour_sum_operator    = cvip::core::basic_operator<neighbour_sum_predicate>;
+
+}
+
+
+// The unit test
+//
+// InPlace::StagesReuseTheirUnsharedSource
+//
+// test that operator_expression::apply defined in src/cvip/expression.cpp
+// hands in-place capable predicates their own source as target, except on
+// the input of the expression, which is never written.
+//
+
+TEST(InPlace, StagesReuseTheirUnsharedSource)
+{
+    auto ex = in_place_operator{ } * out_of_place_operator{ } * in_place_operator{ } * in_place_operator{ };
+
+    auto const x = matrix(3, 3, CV_32SC1, cv::Scalar::all(0));
+
+    increment_predicate<true>::aliased.clear();
+    increment_predicate<false>::aliased.clear();
+
+    auto const y = ex * x;
+
+    EXPECT_EQ(y.at<int>(2, 2), 4);
+    EXPECT_EQ(x.at<int>(2, 2), 0);
+    EXPECT_NE(y.data, x.data);
+
+    EXPECT_THAT(increment_predicate<true>::aliased, testing::ElementsAre(false, true, true));
+    EXPECT_THAT(increment_predicate<false>::aliased, testing::ElementsAre(false));
+}
+
+
+// The unit test
+//
+// InPlace::StaticExpressionsReuseTheirUnsharedSource
+//
+// test that static_expression::apply defined in internal/static_expression.inl
+// hands in-place capable predicates their own source as target, except on
+// the input of the expression, which is never written.
+//
+
+TEST(InPlace, StaticExpressionsReuseTheirUnsharedSource)
+{
+    auto ex = cvip::core::make_static(in_place_operator{ }, in_place_operator{ }, out_of_place_operator{ });
+
+    auto const x = matrix(3, 3, CV_32SC1, cv::Scalar::all(0));
+
+    increment_predicate<true>::aliased.clear();
+    increment_predicate<false>::aliased.clear();
+
+    auto const y = ex * x;
+
+    EXPECT_EQ(y.at<int>(2, 2), 3);
+    EXPECT_EQ(x.at<int>(2, 2), 0);
+
+    EXPECT_THAT(increment_predicate<false>::aliased, testing::ElementsAre(false));
+    EXPECT_THAT(increment_predicate<true>::aliased, testing::ElementsAre(true, true));
+}
+
+
+// The unit test
+//
+// InPlace::NextStageDoesNotWriteItsSource
+//
+// test that, after an in-place stage, a stage that does not work in place
+// is not given its own source as target, in dynamic and static expressions.
+//
+
+TEST(InPlace, NextStageDoesNotWriteItsSource)
+{
+    auto const x = matrix(1, 4, CV_32SC1, cv::Scalar::all(10));
+
+    auto dynamic_ex = neighbour_sum_operator{ } * shared_increment_operator{ } * out_of_place_operator{ };
+    auto static_ex  = cvip::core::make_static(neighbour_sum_operator{ }, shared_increment_operator{ },
+                                              out_of_place_operator{ });
+
+    for (auto const& y : { dynamic_ex * x, static_ex * x })
+    {
+        EXPECT_EQ(y.at<int>(0, 0), 12);
+        EXPECT_EQ(y.at<int>(0, 1), 24);
+        EXPECT_EQ(y.at<int>(0, 3), 24);
+    }
+}
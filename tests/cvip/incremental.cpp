@@ -0,0 +1,177 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <stdexcept>
+#include <typeinfo>
+
+
+using cvip::matrix;
+
+
+namespace
+{
+
+    // Predicate that can be retuned, it counts its applications
+    //
+
+    struct offset_predicate
+    {
+        static inline auto calls = 0;
+
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            ++calls;
+
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<int>(y, x) = 10 * src.at<int>(y, x) + offset;
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        void reset(int const value)
+        {
+            offset = value;
+        }
+
+        int offset = 0;
+    };
+
+    using offset_operator = cvip::core::basic_operator<offset_predicate>;
+
+}
+
+
+// The unit test
+//
+// Incremental::OnlyRetunedStagesAreRecomputed
+//
+// test that operator_expression::apply defined in src/cvip/expression.cpp,
+// in incremental mode, recomputes the stages from the first retuned one.
+//
+
+TEST(Incremental, OnlyRetunedStagesAreRecomputed)
+{
+    auto ex = offset_operator{ 4 } * offset_operator{ 3 } * offset_operator{ 2 } * offset_operator{ 1 };
+
+    ex.enable_incremental();
+
+    auto const x = matrix(2, 2, CV_32SC1, cv::Scalar::all(0));
+
+    offset_predicate::calls = 0;
+
+    auto const y1 = ex * x;
+
+    EXPECT_EQ(offset_predicate::calls, 4);
+    EXPECT_EQ(y1.at<int>(1, 1), 1234);
+
+    ex.stage<offset_operator>(3)(9);
+
+    auto const y2 = ex * x;
+
+    EXPECT_EQ(offset_predicate::calls, 5);
+    EXPECT_EQ(y2.at<int>(1, 1), 1239);
+    EXPECT_EQ(y1.at<int>(1, 1), 1234);
+
+    ex.stage<offset_operator>(1)(5);
+
+    auto const y3 = ex * x;
+
+    EXPECT_EQ(offset_predicate::calls, 8);
+    EXPECT_EQ(y3.at<int>(1, 1), 1539);
+
+    auto const y4 = ex * x;
+
+    EXPECT_EQ(offset_predicate::calls, 8);
+    EXPECT_EQ(y4.at<int>(1, 1), 1539);
+
+    auto const z  = matrix(2, 2, CV_32SC1, cv::Scalar::all(1));
+    auto const y5 = ex * z;
+
+    EXPECT_EQ(offset_predicate::calls, 12);
+    EXPECT_EQ(y5.at<int>(1, 1), 11539);
+}
+
+
+// The unit test
+//
+// Incremental::InputIsIdentifiedByItsContent
+//
+// test that, in incremental mode, an input is taken as the last one only
+// if it has the same content, whatever its data, that a buffer reused for
+// another image is recomputed, that the stages are recomputed on request,
+// and that the results returned are not the kept ones.
+//
+
+TEST(Incremental, InputIsIdentifiedByItsContent)
+{
+    auto ex = offset_operator{ 2 } * offset_operator{ 1 };
+
+    ex.enable_incremental();
+
+    auto x = matrix(2, 2, CV_32SC1, cv::Scalar::all(0));
+
+    offset_predicate::calls = 0;
+
+    auto const y1 = ex * x;
+    auto const y2 = ex * x.clone();
+
+    EXPECT_EQ(offset_predicate::calls, 2);
+    EXPECT_EQ(y1.at<int>(1, 1), 12);
+    EXPECT_EQ(y2.at<int>(1, 1), 12);
+
+    x.at<int>(1, 1) = 1;
+
+    auto y3 = ex * x;
+
+    EXPECT_EQ(offset_predicate::calls, 4);
+    EXPECT_EQ(y3.at<int>(1, 1), 112);
+
+    y3.at<int>(1, 1) = 0;
+
+    auto const y4 = ex * x;
+
+    EXPECT_EQ(offset_predicate::calls, 4);
+    EXPECT_EQ(y4.at<int>(1, 1), 112);
+
+    ex.invalidate_input();
+
+    auto const y5 = ex * x;
+
+    EXPECT_EQ(offset_predicate::calls, 6);
+    EXPECT_EQ(y5.at<int>(1, 1), 112);
+    EXPECT_EQ(y1.at<int>(1, 1), 12);
+}
+
+
+// The unit test
+//
+// Incremental::StageAccessIsChecked
+//
+// test that operator_expression::stage reports bad indices and types.
+//
+
+TEST(Incremental, StageAccessIsChecked)
+{
+    struct other_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            cvip::swap(dst, src);
+        }
+    };
+
+    auto ex = offset_operator{ 1 } * offset_operator{ 2 };
+
+    EXPECT_EQ(ex.stage<offset_operator>(1).predicate().offset, 1);
+    EXPECT_THROW(ex.stage<offset_operator>(2), std::out_of_range);
+    EXPECT_THROW(ex.stage<cvip::core::basic_operator<other_predicate>>(0), std::bad_cast);
+}
@@ -0,0 +1,144 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/batch.hpp>
+#include <cvip/numa.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <stdexcept>
+#include <vector>
+
+
+using cvip::matrix;
+using cvip::core::numa_scheduler;
+
+
+namespace
+{
+
+    // Predicate adding an offset to each element, it throws on an image
+    // whose first element is negative
+    //
+
+    struct offset_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            if (src.at<int>(0, 0) < 0)
+            {
+                throw std::runtime_error("negative");
+            }
+
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<int>(y, x) = src.at<int>(y, x) + offset;
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        int offset = 0;
+    };
+
+    using offset_operator = cvip::core::basic_operator<offset_predicate>;
+
+
+    std::vector<matrix> make_frames(int const count)
+    {
+        auto frames = std::vector<matrix>{ };
+
+        for (auto k = 0; k < count; ++k)
+        {
+            frames.push_back(matrix(16, 16, CV_32SC1, cv::Scalar::all(k)));
+        }
+
+        return frames;
+    }
+
+}
+
+
+// The unit test
+//
+// Numa::BatchMatchesSequentialResult
+//
+// test that batch_apply with a numa_scheduler, defined in src/cvip/batch.cpp,
+// gives the results of the sequential batch, in order, that the frames are
+// processed on the bounded allocators of the nodes, and that the results are
+// not allocated on them.
+//
+
+TEST(Numa, BatchMatchesSequentialResult)
+{
+    auto scheduler = numa_scheduler{ 2 };
+
+    EXPECT_GE(scheduler.nodes(), 1u);
+    EXPECT_EQ(scheduler.workers(), 2 * scheduler.nodes());
+
+    auto const frames = make_frames(23);
+
+    auto const ex = offset_operator{ 1 } * offset_operator{ 10 } * offset_operator{ 100 };
+
+    auto const results = cvip::core::batch_apply(ex, frames, scheduler);
+    auto const single  = cvip::core::batch_apply(offset_operator{ 5 }, frames, scheduler);
+
+    ASSERT_EQ(results.size(), frames.size());
+    ASSERT_EQ(single.size(), frames.size());
+
+    auto allocations = std::size_t{ 0 };
+
+    for (auto node = std::size_t{ 0 }; node < scheduler.nodes(); ++node)
+    {
+        auto const& allocator = scheduler.allocator(node);
+
+        allocations += allocator.stats().allocations;
+
+        EXPECT_EQ(allocator.capacity(), numa_scheduler::default_pool_capacity);
+        EXPECT_EQ(allocator.stats().bytes, 0u);
+
+        for (auto k = 0; k < 23; ++k)
+        {
+            EXPECT_FALSE(allocator.owns(results[k]));
+            EXPECT_FALSE(allocator.owns(single[k]));
+        }
+    }
+
+    EXPECT_EQ(allocations, 2 * frames.size());
+
+    for (auto k = 0; k < 23; ++k)
+    {
+        EXPECT_EQ(results[k].at<int>(15, 15), k + 111);
+        EXPECT_EQ(single[k].at<int>(15, 15), k + 5);
+    }
+
+    EXPECT_THROW(scheduler.allocator(scheduler.nodes()), std::out_of_range);
+}
+
+
+// The unit test
+//
+// Numa::ErrorsAreRethrown
+//
+// test that an exception thrown while processing a frame is rethrown by
+// batch_apply, and that the scheduler is usable afterwards.
+//
+
+TEST(Numa, ErrorsAreRethrown)
+{
+    auto scheduler = numa_scheduler{ 2 };
+
+    auto frames = make_frames(8);
+
+    frames[5].at<int>(0, 0) = -1;
+
+    EXPECT_THROW(cvip::core::batch_apply(offset_operator{ 1 }, frames, scheduler), std::runtime_error);
+
+    frames[5].at<int>(0, 0) = 5;
+
+    EXPECT_EQ(cvip::core::batch_apply(offset_operator{ 1 }, frames, scheduler)[5].at<int>(0, 0), 6);
+    EXPECT_TRUE(cvip::core::batch_apply(offset_operator{ 1 }, { }, scheduler).empty());
+}
@@ -0,0 +1,170 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <utility>
+#include <vector>
+
+
+using cvip::matrix;
+
+
+namespace
+{
+
+    // Predicate adding one to each element, optionally in place
+    //
+    template<bool InPlace>
+    struct increment_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first)
+        {
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<int>(y, x) = src.at<int>(y, x) + 1;
+                }
+            }
+
+            if (first)
+            {
+                src = matrix{ };
+            }
+        }
+
+        static constexpr bool in_place()
+        {
+            return InPlace;
+        }
+    };
+
+    using in_place_operator     = cvip::core::basic_operator<increment_predicate<true>>;
+    using out_of_place_operator = cvip::core::basic_operator<increment_predicate<false>>;
+
+
+    // Predicate recording the first flag it is given, it keeps its source
+    // if it is not the first stage
+    //
+    struct recording_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first)
+        {
+            firsts->push_back(first);
+
+            src.copyTo(dst);
+
+            if (first)
+            {
+                src = matrix{ };
+            }
+        }
+
+        std::vector<bool>* firsts = nullptr;
+    };
+
+    using recording_operator = cvip::core::basic_operator<recording_predicate>;
+
+}
+
+
+// The unit test
+//
+// Ownership::UnsharedInputStorageIsReused
+//
+// test that the operator* overloads taking a matrix rvalue, defined in
+// src/cvip/operator.cpp, src/cvip/expression.cpp and static_expression.inl,
+// process an unshared input in its own storage.
+//
+
+TEST(Ownership, UnsharedInputStorageIsReused)
+{
+    auto x1 = matrix(3, 3, CV_32SC1, cv::Scalar::all(0));
+    auto const data1 = x1.data;
+    auto const y1 = in_place_operator{ } * std::move(x1);
+
+    EXPECT_EQ(y1.data, data1);
+    EXPECT_EQ(y1.at<int>(2, 2), 1);
+
+    auto ex = out_of_place_operator{ } * out_of_place_operator{ };
+
+    auto x2 = matrix(3, 3, CV_32SC1, cv::Scalar::all(0));
+    auto const data2 = x2.data;
+    auto const y2 = ex * std::move(x2);
+
+    EXPECT_EQ(y2.data, data2);
+    EXPECT_EQ(y2.at<int>(2, 2), 2);
+
+    auto sx = cvip::core::make_static(out_of_place_operator{ }, out_of_place_operator{ });
+
+    auto x3 = matrix(3, 3, CV_32SC1, cv::Scalar::all(0));
+    auto const data3 = x3.data;
+    auto const y3 = sx * std::move(x3);
+
+    EXPECT_EQ(y3.data, data3);
+    EXPECT_EQ(y3.at<int>(2, 2), 2);
+}
+
+
+// The unit test
+//
+// Ownership::SharedInputIsNotModified
+//
+// test that the operator* overloads taking a matrix rvalue leave an input
+// whose data is shared with another matrix untouched.
+//
+
+TEST(Ownership, SharedInputIsNotModified)
+{
+    auto const image = matrix(6, 6, CV_32SC1, cv::Scalar::all(0));
+
+    auto const y1 = in_place_operator{ } * image(cvip::rect{ 1, 1, 3, 3 });
+
+    EXPECT_EQ(y1.at<int>(2, 2), 1);
+    EXPECT_EQ(image.at<int>(2, 2), 0);
+
+    auto ex = in_place_operator{ } * out_of_place_operator{ };
+
+    auto x = image;
+    auto const y2 = ex * std::move(x);
+
+    EXPECT_NE(y2.data, image.data);
+    EXPECT_EQ(y2.at<int>(2, 2), 2);
+    EXPECT_EQ(image.at<int>(2, 2), 0);
+}
+
+
+// The unit test
+//
+// Ownership::FirstStageIsToldItIsFirst
+//
+// test that the first stage of a chain applied on an unshared input is
+// given first set, as on any other input, and that the input still becomes
+// the destination of the second stage.
+//
+
+TEST(Ownership, FirstStageIsToldItIsFirst)
+{
+    auto firsts = std::vector<bool>{ };
+
+    auto const op = recording_operator{ &firsts };
+
+    auto ex = op * op;
+    auto sx = op * op;
+
+    for (auto k = 0; k < 2; ++k)
+    {
+        auto x = matrix(3, 3, CV_32SC1, cv::Scalar::all(0));
+        auto const data = x.data;
+
+        firsts.clear();
+
+        auto const y = k == 0 ? ex * std::move(x) : sx * std::move(x);
+
+        EXPECT_THAT(firsts, ::testing::ElementsAre(true, false));
+        EXPECT_EQ(y.data, data);
+    }
+}
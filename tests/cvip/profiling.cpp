@@ -0,0 +1,324 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include <cvip/profiling.hpp>
+#include "support.hpp"
+#include <chrono>
+#include <utility>
+
+
+using cvip::matrix;
+
+
+struct copy_predicate
+{
+    void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+    {
+        src.copyTo(dst);
+        src = matrix{ };
+    }
+};
+
+struct swap_predicate
+{
+    void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+    {
+        std::swap(dst, src);
+    }
+};
+
+struct row_copy_predicate
+{
+    void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+    {
+        dst.create(src.rows, src.cols, src.type());
+
+        for (auto y = 0; y < src.rows; ++y)
+        {
+            for (auto x = 0; x < src.cols; ++x)
+            {
+                dst.at<unsigned char>(y, x) = src.at<unsigned char>(y, x);
+            }
+        }
+
+        src = matrix{ };
+    }
+
+    int row_halo() const
+    {
+        return 0;
+    }
+};
+
+struct copy_operator_fake : public cvip::core::base_operator< copy_operator_fake >
+{
+    virtual void apply(matrix& dst, matrix& src, bool const first) override
+    {
+        m_pr.do_apply(dst, src, first);
+    }
+
+    copy_predicate m_pr;
+};
+
+
+// The unit test
+//
+// Profiling::ProfilerAggregatesPerOperatorType
+//
+// test that stage_profiler defined in src/cvip/profiling.cpp gathers the
+// records of each operator type into its own summary and histogram.
+//
+
+TEST(Profiling, ProfilerAggregatesPerOperatorType)
+{
+    using namespace std::chrono_literals;
+
+    auto profiler = cvip::core::stage_profiler{ };
+
+    auto record = cvip::core::stage_record{ };
+
+    record.op_type = typeid(copy_operator_fake);
+    record.elapsed = 1000ns;
+    record.bytes   = 10;
+
+    profiler.stage_end(record);
+
+    record.elapsed     = 3000ns;
+    record.reallocated = true;
+
+    profiler.stage_end(record);
+
+    record.op_type = typeid(cvip::core::basic_operator<copy_predicate>);
+
+    profiler.stage_end(record);
+
+    auto const report = profiler.report();
+
+    ASSERT_EQ(report.size(), 2u);
+
+    auto const& summary = report[0].op_type == typeid(copy_operator_fake) ? report[0] : report[1];
+
+    EXPECT_EQ(summary.calls, 2u);
+    EXPECT_EQ(summary.reallocations, 1u);
+    EXPECT_EQ(summary.bytes, 20u);
+    EXPECT_EQ(summary.total, 4000ns);
+    EXPECT_EQ(summary.min, 1000ns);
+    EXPECT_EQ(summary.max, 3000ns);
+    EXPECT_EQ(summary.histogram[10], 1u);
+    EXPECT_EQ(summary.histogram[12], 1u);
+}
+
+
+// The unit test
+//
+// Profiling::ProfilerAddsHardwareCounts
+//
+// test that stage_profiler adds up the hardware counts of the records that
+// have them, and that it asks for them only when built for counting.
+//
+
+TEST(Profiling, ProfilerAddsHardwareCounts)
+{
+    auto profiler = cvip::core::stage_profiler{ true };
+
+    auto record = cvip::core::stage_record{ };
+
+    record.op_type               = typeid(copy_operator_fake);
+    record.counted               = true;
+    record.counters.cycles       = 100;
+    record.counters.instructions = 250;
+    record.counters.llc_loads    = 4;
+
+    profiler.stage_end(record);
+    profiler.stage_end(record);
+
+    record.counted = false;
+
+    profiler.stage_end(record);
+
+    auto const report = profiler.report();
+
+    ASSERT_EQ(report.size(), 1u);
+    EXPECT_EQ(report[0].calls, 3u);
+    EXPECT_EQ(report[0].counted, 2u);
+    EXPECT_EQ(report[0].counters.cycles, 200u);
+    EXPECT_EQ(report[0].counters.instructions, 500u);
+    EXPECT_EQ(report[0].counters.llc_loads, 8u);
+    EXPECT_EQ(report[0].counters.llc_stores, 0u);
+
+    EXPECT_TRUE(profiler.counting());
+    EXPECT_FALSE(cvip::core::stage_profiler{ }.counting());
+}
+
+
+// The unit test
+//
+// Profiling::ExpressionStagesAreReported
+//
+// test the instrumentation hooks in src/cvip/expression.cpp and
+// src/cvip/operator.cpp, only when they are compiled in.
+//
+
+#if defined(CVIP_CONFIG_ENABLE_PROFILING)
+
+TEST(Profiling, ExpressionStagesAreReported)
+{
+    using copy_operator = cvip::core::basic_operator<copy_predicate>;
+
+    auto profiler = cvip::core::stage_profiler{ };
+
+    auto op1 = copy_operator{ };
+    auto op2 = copy_operator_fake{ };
+    auto x   = matrix(4, 4, CV_8UC1, cv::Scalar::all(0));
+
+    cvip::core::set_stage_observer(&profiler);
+
+    auto y1 = op2 * op1 * op2 * x;
+    auto y2 = op1 * x;
+
+    cvip::core::set_stage_observer(nullptr);
+
+    auto const report = profiler.report();
+
+    ASSERT_EQ(report.size(), 2u);
+
+    for (auto const& summary : report)
+    {
+        EXPECT_EQ(summary.calls, 2u);
+        EXPECT_EQ(summary.bytes, 2u * 32u);
+    }
+}
+
+
+// The unit test
+//
+// Profiling::StagesAreCounted
+//
+// test that, when the system provides hardware counters, every stage is
+// counted for an observer that asks for it.
+//
+
+TEST(Profiling, StagesAreCounted)
+{
+    using copy_operator = cvip::core::basic_operator<copy_predicate>;
+
+    auto counters  = cvip::core::stage_counters{ };
+    auto available = cvip::core::detail::read_counters(counters);
+
+    auto profiler = cvip::core::stage_profiler{ true };
+
+    auto op1 = copy_operator{ };
+    auto op2 = copy_operator_fake{ };
+    auto x   = matrix(64, 64, CV_8UC1, cv::Scalar::all(0));
+
+    cvip::core::set_stage_observer(&profiler);
+
+    auto y = op2 * op1 * x;
+
+    cvip::core::set_stage_observer(nullptr);
+
+    auto const report = profiler.report();
+
+    ASSERT_EQ(report.size(), 2u);
+
+    for (auto const& summary : report)
+    {
+        EXPECT_EQ(summary.counted, available ? summary.calls : 0u);
+
+        if (available)
+        {
+            EXPECT_GT(summary.counters.instructions, 0u);
+        }
+    }
+}
+
+
+
+// The unit test
+//
+// Profiling::SwappedBuffersAreNotReallocations
+//
+// test that a stage handing back the buffer it got in src, as the swap
+// protocol does, is not reported as a reallocation, while one writing into
+// a new buffer is.
+//
+
+TEST(Profiling, SwappedBuffersAreNotReallocations)
+{
+    using copy_operator = cvip::core::basic_operator<copy_predicate>;
+    using swap_operator = cvip::core::basic_operator<swap_predicate>;
+
+    auto profiler = cvip::core::stage_profiler{ };
+
+    auto op1 = copy_operator{ };
+    auto op2 = swap_operator{ };
+    auto x   = matrix(4, 4, CV_8UC1, cv::Scalar::all(0));
+
+    cvip::core::set_stage_observer(&profiler);
+
+    auto y = op2 * op1 * op2 * x;
+
+    cvip::core::set_stage_observer(nullptr);
+
+    auto const report = profiler.report();
+
+    ASSERT_EQ(report.size(), 2u);
+
+    for (auto const& summary : report)
+    {
+        EXPECT_EQ(summary.reallocations, summary.op_type == typeid(copy_operator) ? 1u : 0u);
+    }
+}
+
+
+// The unit test
+//
+// Profiling::StripesAreCounted
+//
+// test that the stripes of a striped stage, run by cv::parallel_for_
+// workers, are counted with the stage, i.e. that it takes about as many
+// instructions as the same stage applied on the whole image at once.
+//
+
+TEST(Profiling, StripesAreCounted)
+{
+    using row_copy_operator = cvip::core::basic_operator<row_copy_predicate>;
+
+    auto counters  = cvip::core::stage_counters{ };
+    auto available = cvip::core::detail::read_counters(counters);
+
+    auto whole   = row_copy_operator{ };
+    auto striped = row_copy_operator{ };
+    auto x       = matrix(512, 512, CV_8UC1, cv::Scalar::all(1));
+
+    whole.execution(cvip::execution_model::sequential);
+
+    auto whole_profiler   = cvip::core::stage_profiler{ true };
+    auto striped_profiler = cvip::core::stage_profiler{ true };
+
+    cvip::core::set_stage_observer(&whole_profiler);
+
+    auto y1 = whole * x;
+
+    cvip::core::set_stage_observer(&striped_profiler);
+
+    auto y2 = striped * x;
+
+    cvip::core::set_stage_observer(nullptr);
+
+    auto const whole_report   = whole_profiler.report();
+    auto const striped_report = striped_profiler.report();
+
+    ASSERT_EQ(whole_report.size(), 1u);
+    ASSERT_EQ(striped_report.size(), 1u);
+
+    EXPECT_EQ(striped_report[0].counted, available ? 1u : 0u);
+
+    if (available)
+    {
+        EXPECT_GT(2 * striped_report[0].counters.instructions, whole_report[0].counters.instructions);
+    }
+}
+
+#endif // defined(CVIP_CONFIG_ENABLE_PROFILING)
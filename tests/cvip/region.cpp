@@ -0,0 +1,160 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+
+using cvip::matrix;
+
+
+namespace
+{
+
+    // A local predicate, the sum of each pixel and its eight neighbours,
+    // borders are replicated. It is written pixel by pixel so that its
+    // result depends on the actual extent of the image it receives, and it
+    // records the first input it gets.
+    //
+
+    struct box_sum_predicate
+    {
+        static inline auto input = static_cast<void const*>(nullptr);
+
+        void do_apply(matrix& dst, matrix& src, bool const first)
+        {
+            if (first)
+            {
+                input = src.data;
+            }
+
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    auto value = 0;
+
+                    for (auto v = y - 1; v <= y + 1; ++v)
+                    {
+                        for (auto u = x - 1; u <= x + 1; ++u)
+                        {
+                            value += src.at<int>(std::clamp(v, 0, src.rows - 1), std::clamp(u, 0, src.cols - 1));
+                        }
+                    }
+
+                    dst.at<int>(y, x) = value;
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        int halo() const
+        {
+            return 1;
+        }
+    };
+
+    // A predicate that does not declare a halo
+    //
+
+    struct copy_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            src.copyTo(dst);
+            src = matrix{ };
+        }
+    };
+
+    using box_sum_operator = cvip::core::basic_operator<box_sum_predicate>;
+    using copy_operator    = cvip::core::basic_operator<copy_predicate>;
+
+}
+
+
+// The unit test
+//
+// Region::MatchesWholeImageResult
+//
+// test that operator_expression::apply_region defined in
+// src/cvip/expression.cpp gives the region of the result on the whole
+// image, in the interior and at the borders, that it works on the image
+// itself, and that it writes into the region of a caller's image, also
+// through a temporary header.
+//
+
+TEST(Region, MatchesWholeImageResult)
+{
+    auto x = matrix(40, 30, CV_32SC1);
+
+    for (auto y = 0; y < x.rows; ++y)
+    {
+        for (auto c = 0; c < x.cols; ++c)
+        {
+            x.at<int>(y, c) = (y * 31 + c * 7) % 13;
+        }
+    }
+
+    auto ex = box_sum_operator{ } * box_sum_operator{ } * box_sum_operator{ };
+
+    auto const expected = ex * x;
+
+    auto result = matrix(x.rows, x.cols, CV_32SC1, cv::Scalar::all(-1));
+
+    for (auto const region : { cv::Rect{ 10, 12, 6, 5 }, cv::Rect{ 0, 0, 4, 3 }, cv::Rect{ 27, 35, 3, 5 } })
+    {
+        auto output = result(region);
+
+        ex.apply_region(x, region, output);
+
+        EXPECT_EQ(box_sum_predicate::input, &x.at<int>(std::max(region.y - 3, 0), std::max(region.x - 3, 0)));
+        EXPECT_EQ(output.data, result(region).data);
+        EXPECT_EQ(cv::norm(result(region), expected(region), cv::NORM_INF), 0.0);
+    }
+
+    EXPECT_EQ(result.at<int>(20, 20), -1);
+
+    ex.apply_region(x, cv::Rect{ 18, 18, 4, 4 }, result(cv::Rect{ 18, 18, 4, 4 }));
+
+    EXPECT_EQ(cv::norm(result(cv::Rect{ 18, 18, 4, 4 }), expected(cv::Rect{ 18, 18, 4, 4 }), cv::NORM_INF), 0.0);
+
+    auto fresh = matrix{ };
+
+    ex.apply_region(x, cv::Rect{ 5, 6, 7, 8 }, fresh);
+
+    EXPECT_EQ(fresh.rows, 8);
+    EXPECT_EQ(fresh.cols, 7);
+    EXPECT_EQ(cv::norm(fresh, expected(cv::Rect{ 5, 6, 7, 8 }), cv::NORM_INF), 0.0);
+}
+
+
+// The unit test
+//
+// Region::InvalidRegionsAreRejected
+//
+// test that operator_expression::apply_region rejects non local chains,
+// regions out of the image and outputs of the wrong size.
+//
+
+TEST(Region, InvalidRegionsAreRejected)
+{
+    auto const x = matrix(10, 10, CV_32SC1, cv::Scalar::all(1));
+
+    auto output = matrix{ };
+
+    auto local     = box_sum_operator{ } * box_sum_operator{ };
+    auto non_local = box_sum_operator{ } * copy_operator{ };
+
+    EXPECT_THROW(non_local.apply_region(x, cv::Rect{ 2, 2, 3, 3 }, output), std::invalid_argument);
+    EXPECT_THROW(local.apply_region(x, cv::Rect{ 8, 8, 3, 3 }, output), std::out_of_range);
+    EXPECT_THROW(local.apply_region(x, cv::Rect{ 2, 2, 0, 3 }, output), std::out_of_range);
+
+    auto small = matrix(2, 3, CV_32SC1);
+
+    EXPECT_THROW(local.apply_region(x, cv::Rect{ 2, 2, 3, 3 }, small), std::invalid_argument);
+}
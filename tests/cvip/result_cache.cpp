@@ -0,0 +1,223 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include <cvip/result_cache.hpp>
+#include "support.hpp"
+
+
+using cvip::matrix;
+
+
+namespace
+{
+
+    // Predicate exposing its parameters through a fingerprint
+    //
+
+    struct offset_predicate
+    {
+        static inline auto calls = 0;
+
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            ++calls;
+
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<int>(y, x) = src.at<int>(y, x) + offset;
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        std::size_t fingerprint() const
+        {
+            return static_cast<std::size_t>(offset);
+        }
+
+        int offset = 0;
+    };
+
+    // Predicate with a state, but no fingerprint
+    //
+
+    struct opaque_predicate
+    {
+        static inline auto calls = 0;
+
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            ++calls;
+
+            src.copyTo(dst);
+            src = matrix{ };
+        }
+
+        int state = 0;
+    };
+
+    using offset_operator = cvip::core::basic_operator<offset_predicate>;
+    using opaque_operator = cvip::core::basic_operator<opaque_predicate>;
+
+}
+
+
+// The unit test
+//
+// ResultCache::RepeatedApplyIsServedFromCache
+//
+// test that operator_expression::apply defined in src/cvip/expression.cpp
+// returns the cached result of a chain on an input with the same content,
+// and recomputes it when the content or the operator parameters change.
+//
+
+TEST(ResultCache, RepeatedApplyIsServedFromCache)
+{
+    auto cache = std::make_shared<cvip::core::result_cache>();
+
+    auto ex1 = offset_operator{ 1 } * offset_operator{ 2 };
+    auto ex2 = offset_operator{ 1 } * offset_operator{ 3 };
+
+    ex1.attach_cache(cache);
+    ex2.attach_cache(cache);
+
+    auto const x = matrix(4, 4, CV_32SC1, cv::Scalar::all(5));
+    auto const z = x.clone();
+
+    offset_predicate::calls = 0;
+
+    auto const y1 = ex1 * x;
+    auto const y2 = ex1 * z;
+    auto const y3 = ex2 * x;
+
+    EXPECT_EQ(offset_predicate::calls, 4);
+    EXPECT_EQ(y1.data, y2.data);
+    EXPECT_EQ(y2.at<int>(3, 3), 8);
+    EXPECT_EQ(y3.at<int>(3, 3), 9);
+
+    auto w = x.clone();
+
+    w.at<int>(2, 1) = 0;
+
+    auto const y4 = ex1 * w;
+
+    EXPECT_EQ(offset_predicate::calls, 6);
+    EXPECT_EQ(y4.at<int>(2, 1), 3);
+
+    auto const stats = cache->stats();
+
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 3u);
+    EXPECT_EQ(stats.entries, 3u);
+}
+
+
+// The unit test
+//
+// ResultCache::OpaqueChainsAreNotCached
+//
+// test that a chain with an operator that has no fingerprint is always
+// recomputed.
+//
+
+TEST(ResultCache, OpaqueChainsAreNotCached)
+{
+    auto ex = offset_operator{ 1 } * opaque_operator{ };
+
+    ex.enable_caching();
+
+    auto const x = matrix(4, 4, CV_32SC1, cv::Scalar::all(5));
+
+    opaque_predicate::calls = 0;
+
+    auto const y1 = ex * x;
+    auto const y2 = ex * x;
+
+    EXPECT_EQ(opaque_predicate::calls, 2);
+    EXPECT_EQ(ex.cache()->stats().entries, 0u);
+}
+
+
+// The unit test
+//
+// ResultCache::CapacityIsHonoured
+//
+// test that the result_cache class defined in src/cvip/result_cache.cpp
+// drops the least recently used results to honour its capacity.
+//
+
+TEST(ResultCache, CapacityIsHonoured)
+{
+    auto cache = cvip::core::result_cache{ 150 };
+
+    auto const a = matrix(4, 4, CV_32SC1, cv::Scalar::all(1));
+    auto const b = matrix(4, 4, CV_32SC1, cv::Scalar::all(2));
+    auto const c = matrix(4, 4, CV_32SC1, cv::Scalar::all(3));
+
+    auto const ka = cvip::core::result_cache::make_key(7, a);
+    auto const kb = cvip::core::result_cache::make_key(7, b);
+    auto const kc = cvip::core::result_cache::make_key(7, c);
+
+    EXPECT_NE(ka.content, kb.content);
+
+    cache.insert(ka, a);
+    cache.insert(kb, b);
+
+    EXPECT_TRUE(cache.find(ka));
+
+    cache.insert(kc, c);
+
+    auto const stats = cache.stats();
+
+    EXPECT_TRUE(cache.find(ka));
+    EXPECT_FALSE(cache.find(kb));
+    EXPECT_TRUE(cache.find(kc));
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.bytes, 128u);
+}
+
+
+// The unit test
+//
+// ResultCache::HitsAreKeyedByContentAndShared
+//
+// test that the result_cache class keys the results by a 128-bit hash of
+// the input content, so that inputs differing in a single element miss,
+// and that it hands out the cached result without copying it.
+//
+
+TEST(ResultCache, HitsAreKeyedByContentAndShared)
+{
+    auto cache = cvip::core::result_cache{ };
+
+    auto a = matrix(4, 4, CV_32SC1, cv::Scalar::all(1));
+
+    auto const r = matrix(4, 4, CV_32SC1, cv::Scalar::all(2));
+
+    auto const key = cvip::core::result_cache::make_key(7, a);
+
+    cache.insert(key, r);
+
+    a.at<int>(3, 3) = 0;
+
+    auto const other = cvip::core::result_cache::make_key(7, a);
+
+    EXPECT_NE(other.content[0], key.content[0]);
+    EXPECT_NE(other.content[1], key.content[1]);
+    EXPECT_FALSE(cache.find(other));
+
+    a.at<int>(3, 3) = 1;
+
+    auto const hit = cache.find(cvip::core::result_cache::make_key(7, a));
+
+    ASSERT_TRUE(hit);
+    EXPECT_EQ(hit->data, r.data);
+    EXPECT_EQ(cache.stats().hits, 1u);
+    EXPECT_EQ(cache.stats().misses, 1u);
+}
@@ -0,0 +1,227 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include <cvip/rewrite.hpp>
+#include "support.hpp"
+#include <stdexcept>
+
+
+using cvip::matrix;
+
+
+namespace
+{
+
+    // Involutive predicate
+    //
+
+    struct invert_predicate
+    {
+        static inline auto calls = 0;
+
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            ++calls;
+
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<float>(y, x) = -src.at<float>(y, x);
+                }
+            }
+
+            src = matrix{ };
+        }
+    };
+
+    // Affine intensity transform, alpha * x + beta
+    //
+
+    struct affine_predicate
+    {
+        static inline auto calls = 0;
+
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            ++calls;
+
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<float>(y, x) = alpha * src.at<float>(y, x) + beta;
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        bool identity() const
+        {
+            return alpha == 1.0f and beta == 0.0f;
+        }
+
+        float alpha = 1.0f;
+        float beta  = 0.0f;
+    };
+
+    using invert_operator = cvip::core::basic_operator<invert_predicate>;
+    using affine_operator = cvip::core::basic_operator<affine_predicate>;
+
+
+    void reset_calls()
+    {
+        invert_predicate::calls = 0;
+        affine_predicate::calls = 0;
+    }
+
+}
+
+
+// The unit tests
+//
+// Rewrite::InvolutivePairsCancel,
+//
+// and
+//
+// Rewrite::AffineOperationsAreFolded
+//
+// test that operator_expression::optimize defined in src/cvip/expression.cpp
+// rewrites pairs of adjacent operators with the rules in a rewrite_rules set
+// defined in src/cvip/rewrite.cpp, and that applying an expression does not
+// rewrite it.
+//
+
+TEST(Rewrite, InvolutivePairsCancel)
+{
+    auto rules = cvip::core::rewrite_rules{ };
+
+    rules.add<invert_operator, invert_operator>([](invert_operator const&, invert_operator const&)
+    {
+        return cvip::core::rewrite_as();
+    });
+
+    auto inv = invert_operator{ };
+    auto x   = make_ramp(3, 5, CV_32FC1);
+
+    auto ex2 = inv * inv;
+    auto ex3 = inv * inv * inv;
+
+    ex2.optimize(rules);
+    ex3.optimize(rules);
+
+    reset_calls();
+
+    auto const y2 = ex2 * x;
+    auto const y3 = ex3 * x;
+
+    EXPECT_EQ(invert_predicate::calls, 1);
+    EXPECT_NE(y2.data, x.data);
+    EXPECT_EQ(y2.at<float>(2, 4), 26.0f);
+    EXPECT_EQ(y3.at<float>(2, 4), -26.0f);
+}
+
+
+TEST(Rewrite, AffineOperationsAreFolded)
+{
+    cvip::core::add_rewrite_rule<affine_operator, affine_operator>(
+        [](affine_operator const& first, affine_operator const& second)
+        {
+            auto const& a = first.predicate();
+            auto const& b = second.predicate();
+
+            return cvip::core::rewrite_as(affine_operator{ b.alpha * a.alpha, b.alpha * a.beta + b.beta });
+        });
+
+    auto const x = make_ramp(3, 5, CV_32FC1);
+
+    auto ex = affine_operator{ 2.0f, 1.0f } * affine_operator{ 0.5f, 3.0f } * affine_operator{ 4.0f, 0.0f };
+
+    reset_calls();
+
+    auto const y1 = ex * x;
+
+    EXPECT_EQ(affine_predicate::calls, 3);
+
+    ex.optimize();
+
+    reset_calls();
+
+    auto const y2 = ex * x;
+
+    EXPECT_EQ(affine_predicate::calls, 1);
+    EXPECT_EQ(y1.at<float>(2, 4), 2.0f * (0.5f * (4.0f * 26.0f) + 3.0f) + 1.0f);
+    EXPECT_EQ(y2.at<float>(2, 4), y1.at<float>(2, 4));
+}
+
+
+// The unit test
+//
+// Rewrite::IdentityOperatorsAreDropped
+//
+// test that operators that declare themselves as an identity are dropped,
+// and that applying an empty chain produces a copy of the operand.
+//
+
+TEST(Rewrite, IdentityOperatorsAreDropped)
+{
+    auto const x = make_ramp(3, 5, CV_32FC1);
+
+    auto ex1 = affine_operator{ } * invert_operator{ } * affine_operator{ };
+    auto ex2 = affine_operator{ } * affine_operator{ };
+
+    ex1.optimize();
+    ex2.optimize();
+
+    reset_calls();
+
+    auto const y1 = ex1 * x;
+    auto const y2 = ex2 * x;
+
+    EXPECT_EQ(affine_predicate::calls, 0);
+    EXPECT_EQ(invert_predicate::calls, 1);
+    EXPECT_EQ(y1.at<float>(1, 1), -10.0f);
+    EXPECT_NE(y2.data, x.data);
+    EXPECT_EQ(y2.at<float>(1, 1), 10.0f);
+}
+
+
+// The unit test
+//
+// Rewrite::RulesMayAddRulesAndMustConverge
+//
+// test that a rule may add rules to the set it belongs to while it is
+// applied, and that rules that rewrite a chain forever are reported.
+//
+
+TEST(Rewrite, RulesMayAddRulesAndMustConverge)
+{
+    auto rules = cvip::core::rewrite_rules{ };
+
+    rules.add<invert_operator>([&rules](invert_operator const&)
+    {
+        rules.add<affine_operator>([](affine_operator const& op)
+        {
+            return cvip::core::rewrite_as(affine_operator{ op.predicate() });
+        });
+
+        return cvip::core::rewrite_t{ };
+    });
+
+    auto ex1 = invert_operator{ } * invert_operator{ };
+    auto ex2 = affine_operator{ 2.0f, 1.0f } * affine_operator{ 0.5f, 3.0f };
+
+    ex1.optimize(rules);
+
+    EXPECT_THROW(ex2.optimize(rules), std::runtime_error);
+
+    auto const y = ex2 * make_ramp(3, 5, CV_32FC1);
+
+    EXPECT_EQ(y.at<float>(2, 4), 2.0f * (0.5f * 26.0f + 3.0f) + 1.0f);
+}
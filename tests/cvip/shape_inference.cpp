@@ -0,0 +1,158 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <stdexcept>
+#include <vector>
+
+
+using cvip::matrix;
+using cvip::matrix_shape;
+
+
+namespace
+{
+
+    // Predicates converting between depths, they record whether they were
+    // handed a destination of the right size and type
+    //
+
+    template<int From, int To, typename In, typename Out>
+    struct convert_predicate
+    {
+        static inline auto preallocated = std::vector<bool>{ };
+
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            preallocated.push_back(dst.rows == src.rows and dst.cols == src.cols and dst.type() == To);
+
+            dst.create(src.rows, src.cols, To);
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<Out>(y, x) = static_cast<Out>(src.at<In>(y, x) / 2);
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        matrix_shape output_shape(matrix_shape const& input) const
+        {
+            if (input.type != From)
+            {
+                throw std::invalid_argument("convert_predicate: unsupported input type");
+            }
+
+            return { input.rows, input.cols, To };
+        }
+    };
+
+    using to_float_predicate = convert_predicate<CV_8UC1, CV_32FC1, cvip::upix_t, float>;
+    using halve_predicate    = convert_predicate<CV_32FC1, CV_32FC1, float, float>;
+    using to_byte_predicate  = convert_predicate<CV_32FC1, CV_8UC1, float, cvip::upix_t>;
+
+    using to_float_operator = cvip::core::basic_operator<to_float_predicate>;
+    using halve_operator    = cvip::core::basic_operator<halve_predicate>;
+    using to_byte_operator  = cvip::core::basic_operator<to_byte_predicate>;
+
+
+    // Predicate that does not declare its output shape
+    //
+
+    struct opaque_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            src.copyTo(dst);
+            src = matrix{ };
+        }
+    };
+
+    using opaque_operator = cvip::core::basic_operator<opaque_predicate>;
+
+}
+
+
+// The unit test
+//
+// ShapeInference::UnsupportedInputFailsBeforePixelWork
+//
+// test that operator_expression::apply defined in src/cvip/expression.cpp
+// rejects an input an operator in the chain does not support before any
+// operator is applied.
+//
+
+TEST(ShapeInference, UnsupportedInputFailsBeforePixelWork)
+{
+    auto ex = to_byte_operator{ } * to_float_operator{ } * to_float_operator{ };
+
+    auto const x = matrix(4, 4, CV_8UC1, cv::Scalar::all(8));
+
+    to_float_predicate::preallocated.clear();
+
+    EXPECT_THROW(ex * x, std::invalid_argument);
+    EXPECT_TRUE(to_float_predicate::preallocated.empty());
+}
+
+
+// The unit test
+//
+// ShapeInference::IntermediateResultsArePreallocated
+//
+// test that the intermediate results of a chain of operators that declare
+// their output shape are written into buffers of the right size and type,
+// and that neither the first stage, which gets an empty destination, nor the
+// result are given one of them.
+//
+
+TEST(ShapeInference, IntermediateResultsArePreallocated)
+{
+    auto ex = to_byte_operator{ } * halve_operator{ } * to_float_operator{ };
+
+    auto const x = matrix(4, 4, CV_8UC1, cv::Scalar::all(8));
+
+    to_float_predicate::preallocated.clear();
+    halve_predicate::preallocated.clear();
+    to_byte_predicate::preallocated.clear();
+
+    auto const y1 = ex * x;
+
+    EXPECT_THAT(to_float_predicate::preallocated, testing::ElementsAre(false));
+    EXPECT_THAT(halve_predicate::preallocated, testing::ElementsAre(true));
+    EXPECT_THAT(to_byte_predicate::preallocated, testing::ElementsAre(false));
+
+    auto const y2 = ex * matrix(4, 4, CV_8UC1, cv::Scalar::all(40));
+
+    EXPECT_EQ(y1.type(), CV_8UC1);
+    EXPECT_EQ(y1.at<cvip::upix_t>(3, 3), 1);
+    EXPECT_EQ(y2.at<cvip::upix_t>(3, 3), 5);
+}
+
+
+// The unit test
+//
+// ShapeInference::ChainShapeIsInferred
+//
+// test that operator_expression::infer reports the shape of the result of
+// the chain, or nothing if an operator does not declare its output shape.
+//
+
+TEST(ShapeInference, ChainShapeIsInferred)
+{
+    auto const ex1 = to_byte_operator{ } * halve_operator{ } * to_float_operator{ };
+    auto const ex2 = opaque_operator{ } * to_float_operator{ };
+
+    auto const shape = ex1.infer({ 3, 5, CV_8UC1 });
+
+    ASSERT_TRUE(shape);
+    EXPECT_EQ(shape->rows, 3);
+    EXPECT_EQ(shape->cols, 5);
+    EXPECT_EQ(shape->type, CV_8UC1);
+
+    EXPECT_FALSE(ex2.infer({ 3, 5, CV_8UC1 }));
+    EXPECT_THROW(ex1.infer({ 3, 5, CV_32FC1 }), std::invalid_argument);
+}
@@ -0,0 +1,197 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include <stdexcept>
+#include <type_traits>
+
+
+using cvip::matrix;
+
+
+// A predicate that record its tag into the first element of the image so that
+// the order of application can be traced from the resulting matrix.
+//
+
+struct tagging_predicate
+{
+    tagging_predicate(int tag) : m_tag{ tag }
+    {
+        // NOOP
+    }
+
+    void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+    {
+        src.copyTo(dst);
+        dst.at<int>(0, 0) = dst.at<int>(0, 0) * 10 + m_tag;
+        src = matrix{ };
+    }
+
+    void reset(int tag)
+    {
+        m_tag = tag;
+    }
+
+    int m_tag;
+};
+
+using tagging_operator = cvip::core::basic_operator<tagging_predicate>;
+
+
+// A non predicate based operator
+//
+
+struct tagging_operator_fake : public cvip::core::base_operator< tagging_operator_fake >
+{
+    tagging_operator_fake(int tag) : m_tag{ tag }
+    {
+        // NOOP
+    }
+
+    virtual void apply(matrix& dst, matrix& src, bool const first [[maybe_unused]]) override
+    {
+        src.copyTo(dst);
+        dst.at<int>(0, 0) = dst.at<int>(0, 0) * 10 + m_tag;
+        src = matrix{ };
+    }
+
+    int m_tag;
+};
+
+
+// A static expression returned as a dynamic expression
+//
+
+namespace
+{
+
+    cvip::core::operator_expression make_expression()
+    {
+        return cvip::core::make_static(tagging_operator{ 2 }, tagging_operator{ 1 });
+    }
+
+}
+
+
+// The unit tests
+//
+// StaticExpression::StaticExpressionsAreOptIn
+//
+// and
+//
+// StaticExpression::ProductWithOtherOperatorsIsDynamic
+//
+// test that make_static defined in include/cvip/internal/static_expression.inl
+// produces a static_expression that products with basic operators extend,
+// that products of basic operators are dynamic otherwise, and that mixing
+// with any other operator falls back to operator_expression.
+//
+
+TEST(StaticExpression, StaticExpressionsAreOptIn)
+{
+    using cvip::core::make_static;
+    using cvip::core::operator_expression;
+    using cvip::core::static_expression;
+
+    auto op1 = tagging_operator{ 1 };
+    auto op2 = tagging_operator{ 2 };
+
+    static_assert(std::is_same<decltype(op2 * op1), operator_expression>::value);
+
+    static_assert(std::is_same<decltype(make_static(op2, op1)),
+                               static_expression<tagging_predicate, tagging_predicate>>::value);
+
+    static_assert(std::is_same<decltype(op2 * make_static(op2, op1)),
+                               static_expression<tagging_predicate, tagging_predicate, tagging_predicate>>::value);
+
+    static_assert(std::is_same<decltype(make_static(op2, op1) * make_static(op2, op1)),
+                               static_expression<tagging_predicate, tagging_predicate,
+                                                 tagging_predicate, tagging_predicate>>::value);
+}
+
+
+TEST(StaticExpression, ProductWithOtherOperatorsIsDynamic)
+{
+    using cvip::core::make_static;
+    using cvip::core::operator_expression;
+
+    auto op1 = tagging_operator{ 1 };
+    auto op2 = tagging_operator{ 2 };
+    auto op3 = tagging_operator_fake{ 3 };
+
+    static_assert(std::is_same<decltype(op3 * make_static(op2, op1)), operator_expression>::value);
+    static_assert(std::is_same<decltype(make_static(op2, op1) * op3), operator_expression>::value);
+}
+
+
+// The unit tests
+//
+// StaticExpression::PredicatesGetAppliedInProperOrder
+//
+// and
+//
+// StaticExpression::StaticExpressionNestsInDynamicExpression
+//
+// test that the predicates in a static expression are applied from right to
+// left, just as in an operator_expression, also when the static expression is
+// gathered as a single operator into an operator_expression.
+//
+
+TEST(StaticExpression, PredicatesGetAppliedInProperOrder)
+{
+    using cvip::core::make_static;
+
+    auto op1 = tagging_operator{ 1 };
+    auto op2 = tagging_operator{ 2 };
+    auto op3 = tagging_operator{ 3 };
+    auto x   = cvip::matrix(1, 1, CV_32SC1, cv::Scalar::all(0));
+
+    auto y = make_static(op3) * make_static(op2, op1) * op2 * x;
+
+    EXPECT_EQ(y.at<int>(0, 0), 2123);
+    EXPECT_EQ(x.at<int>(0, 0), 0);
+}
+
+
+TEST(StaticExpression, StaticExpressionNestsInDynamicExpression)
+{
+    using cvip::core::make_static;
+
+    auto op1 = tagging_operator{ 1 };
+    auto op2 = tagging_operator{ 2 };
+    auto op3 = tagging_operator_fake{ 3 };
+    auto x   = cvip::matrix(1, 1, CV_32SC1, cv::Scalar::all(0));
+
+    auto y = op3 * make_static(op2, op1) * op3 * x;
+
+    EXPECT_EQ(y.at<int>(0, 0), 3123);
+}
+
+
+// The unit test
+//
+// StaticExpression::ConvertsIntoDynamicExpression
+//
+// test that a static_expression converts implicitly into an
+// operator_expression with one stage per predicate, e.g. when returned
+// from a function declared to return an operator_expression.
+//
+
+TEST(StaticExpression, ConvertsIntoDynamicExpression)
+{
+    auto x = cvip::matrix(1, 1, CV_32SC1, cv::Scalar::all(0));
+
+    auto ex = make_expression();
+
+    EXPECT_EQ((ex * x).at<int>(0, 0), 12);
+    EXPECT_EQ((tagging_operator_fake{ 3 } * ex * x).at<int>(0, 0), 123);
+
+    ex.stage<tagging_operator>(1)(5);
+
+    EXPECT_EQ((ex * x).at<int>(0, 0), 15);
+    EXPECT_THROW(ex.stage<tagging_operator>(2), std::out_of_range);
+
+    ex = cvip::core::make_static(tagging_operator{ 1 }, tagging_operator{ 2 });
+
+    EXPECT_EQ((ex * x).at<int>(0, 0), 21);
+}
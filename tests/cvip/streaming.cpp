@@ -0,0 +1,186 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/mapped_image.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+
+using cvip::matrix;
+using cvip::core::mapped_image;
+
+
+namespace
+{
+
+    // A local predicate, the sum of each pixel and its vertical neighbours,
+    // borders are replicated. It is written pixel by pixel so that its
+    // result depends on the actual extent of the image it receives.
+    //
+
+    struct column_sum_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    auto value = 0;
+
+                    for (auto v = y - 1; v <= y + 1; ++v)
+                    {
+                        value += src.at<int>(std::clamp(v, 0, src.rows - 1), x);
+                    }
+
+                    dst.at<int>(y, x) = value;
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        int halo() const
+        {
+            return 1;
+        }
+    };
+
+    // A predicate that does not declare a halo
+    //
+
+    struct copy_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            src.copyTo(dst);
+            src = matrix{ };
+        }
+    };
+
+    using column_sum_operator = cvip::core::basic_operator<column_sum_predicate>;
+    using copy_operator       = cvip::core::basic_operator<copy_predicate>;
+
+
+    // Path of a file in the temporary directory
+    //
+
+    std::string temporary(std::string const& name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+}
+
+
+// The unit test
+//
+// Streaming::BandsMatchInMemoryResult
+//
+// test that operator_expression::stream defined in src/cvip/expression.cpp
+// gives, band by band, the result of applying the expression in memory,
+// for an input file with a header.
+//
+
+TEST(Streaming, BandsMatchInMemoryResult)
+{
+    auto constexpr header = 16;
+
+    auto const shape = cvip::matrix_shape{ 50, 7, CV_32SC1 };
+
+    auto x = matrix(shape.rows, shape.cols, shape.type);
+
+    for (auto y = 0; y < shape.rows; ++y)
+    {
+        for (auto c = 0; c < shape.cols; ++c)
+        {
+            x.at<int>(y, c) = (y * 31 + c * 7) % 13;
+        }
+    }
+
+    auto const in_path  = temporary("cvip-streaming-in.raw");
+    auto const out_path = temporary("cvip-streaming-out.raw");
+
+    {
+        auto file = std::ofstream(in_path, std::ios::binary | std::ios::trunc);
+
+        file.write("SIMPLE  =      T", header);
+        file.write(reinterpret_cast<char const*>(x.data), static_cast<std::streamsize>(x.total() * x.elemSize()));
+    }
+
+    std::filesystem::remove(out_path);
+
+    auto ex = column_sum_operator{ } * column_sum_operator{ };
+
+    auto const expected = ex * x;
+
+    {
+        auto const in = mapped_image{ in_path, shape, mapped_image::access::read_only, header };
+        auto       out = mapped_image{ out_path, shape, mapped_image::access::read_write };
+
+        ex.stream(in, out, 4 * 7 * sizeof(int));
+
+        auto const y = out.rows(0, shape.rows);
+
+        auto mismatches = 0;
+
+        for (auto r = 0; r < shape.rows; ++r)
+        {
+            for (auto c = 0; c < shape.cols; ++c)
+            {
+                mismatches += y.at<int>(r, c) != expected.at<int>(r, c) ? 1 : 0;
+            }
+        }
+
+        EXPECT_EQ(mismatches, 0);
+    }
+
+    EXPECT_EQ(std::filesystem::file_size(out_path), x.total() * x.elemSize());
+
+    std::filesystem::remove(in_path);
+    std::filesystem::remove(out_path);
+}
+
+
+// The unit test
+//
+// Streaming::InvalidSetupsAreRejected
+//
+// test that streaming rejects chains with non local operators, and that a
+// read only mapped_image rejects a file smaller than the image.
+//
+
+TEST(Streaming, InvalidSetupsAreRejected)
+{
+    auto const shape = cvip::matrix_shape{ 8, 8, CV_32SC1 };
+
+    auto const in_path  = temporary("cvip-streaming-small.raw");
+    auto const out_path = temporary("cvip-streaming-rejected.raw");
+
+    {
+        auto file = std::ofstream(in_path, std::ios::binary | std::ios::trunc);
+
+        file.write("tiny", 4);
+    }
+
+    EXPECT_THROW((mapped_image{ in_path, shape }), std::invalid_argument);
+
+    auto const padded = cvip::matrix_shape{ 1, 1, CV_8UC1 };
+
+    auto const in  = mapped_image{ in_path, padded };
+    auto       out = mapped_image{ out_path, padded, mapped_image::access::read_write };
+
+    auto ex = column_sum_operator{ } * copy_operator{ };
+
+    EXPECT_THROW(ex.stream(in, out), std::invalid_argument);
+
+    std::filesystem::remove(in_path);
+    std::filesystem::remove(out_path);
+}
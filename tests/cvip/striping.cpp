@@ -0,0 +1,189 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <algorithm>
+#include <atomic>
+
+
+using cvip::matrix;
+
+
+namespace
+{
+
+    // Row separable predicate, sums each element with the ones above and
+    // below it, the rows out of the image are taken as zero
+    //
+
+    struct vertical_sum_predicate
+    {
+        static inline auto calls = std::atomic<int>{ 0 };
+
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            ++calls;
+
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    auto sum = src.at<int>(y, x);
+
+                    sum += y > 0 ? src.at<int>(y - 1, x) : 0;
+                    sum += y + 1 < src.rows ? src.at<int>(y + 1, x) : 0;
+
+                    dst.at<int>(y, x) = sum;
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        int row_halo() const
+        {
+            return 1;
+        }
+    };
+
+    // Row separable predicate without halo, sums each element with the one
+    // on its left, it declares the shape of its output
+    //
+
+    struct horizontal_sum_predicate
+    {
+        void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.at<int>(y, x) = src.at<int>(y, x) + (x > 0 ? src.at<int>(y, x - 1) : 0);
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        int row_halo() const
+        {
+            return 0;
+        }
+
+        cvip::matrix_shape output_shape(cvip::matrix_shape const& input) const
+        {
+            return input;
+        }
+    };
+
+    using vertical_sum_operator   = cvip::core::basic_operator<vertical_sum_predicate>;
+    using horizontal_sum_operator = cvip::core::basic_operator<horizontal_sum_predicate>;
+
+
+    bool same_content(matrix const& a, matrix const& b)
+    {
+        if (a.rows != b.rows or a.cols != b.cols or a.type() != b.type())
+        {
+            return false;
+        }
+
+        for (auto y = 0; y < a.rows; ++y)
+        {
+            if (not std::equal(a.ptr<int>(y), a.ptr<int>(y) + a.cols, b.ptr<int>(y)))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+}
+
+
+// The unit test
+//
+// Striping::StripedResultMatchesWholeImageResult
+//
+// test that basic_operator::apply defined in internal/operator.inl splits
+// large images in stripes grown by the row halo of the predicate, if any,
+// and that the result is the same as applying the predicate on the whole
+// image.
+//
+
+TEST(Striping, StripedResultMatchesWholeImageResult)
+{
+    auto const x = make_ramp(512, 256, CV_32SC1);
+
+    auto parallel   = vertical_sum_operator{ };
+    auto sequential = vertical_sum_operator{ };
+
+    sequential.execution(cvip::execution_model::sequential);
+
+    vertical_sum_predicate::calls = 0;
+
+    auto const expected = sequential * x;
+
+    EXPECT_EQ(vertical_sum_predicate::calls, 1);
+
+    auto const result = parallel * x;
+
+    EXPECT_EQ(vertical_sum_predicate::calls, 1 + std::min(cv::getNumThreads(), 512 / 16));
+    EXPECT_TRUE(same_content(result, expected));
+
+    // Without halo, the stripes are staged into the rows of the result
+
+    auto rows = horizontal_sum_operator{ };
+
+    rows.execution(cvip::execution_model::sequential);
+
+    auto const by_rows = rows * x;
+
+    EXPECT_TRUE(same_content(horizontal_sum_operator{ } * x, by_rows));
+    EXPECT_TRUE(same_content(horizontal_sum_operator{ } * (horizontal_sum_operator{ } * x), rows * by_rows));
+}
+
+
+// The unit test
+//
+// Striping::StaticExpressionStagesKeepTheirExecutionModel
+//
+// test that the stages of a static_expression are striped, or not, as the
+// operators they were taken from, and that small images are not striped.
+//
+
+TEST(Striping, StaticExpressionStagesKeepTheirExecutionModel)
+{
+    auto const x = make_ramp(512, 256, CV_32SC1);
+
+    auto sequential = vertical_sum_operator{ };
+
+    sequential.execution(cvip::execution_model::sequential);
+
+    auto ex1 = cvip::core::make_static(sequential, sequential);
+    auto ex2 = cvip::core::make_static(vertical_sum_operator{ }, vertical_sum_operator{ });
+
+    vertical_sum_predicate::calls = 0;
+
+    auto const expected = ex1 * x;
+
+    EXPECT_EQ(vertical_sum_predicate::calls, 2);
+
+    auto const result = ex2 * x;
+
+    EXPECT_EQ(vertical_sum_predicate::calls, 2 + 2 * std::min(cv::getNumThreads(), 512 / 16));
+    EXPECT_TRUE(same_content(result, expected));
+
+    vertical_sum_predicate::calls = 0;
+
+    auto const small = make_ramp(16, 16, CV_32SC1);
+
+    auto const small_result = ex2 * small;
+
+    EXPECT_EQ(vertical_sum_predicate::calls, 2);
+    EXPECT_TRUE(same_content(small_result, ex1 * small));
+}
@@ -0,0 +1,46 @@
+#ifndef CVIP_TESTS_SUPPORT_HPP
+#define CVIP_TESTS_SUPPORT_HPP
+
+#pragma once
+
+
+#include <cvip/internal/basic_imports.hpp>
+
+
+// Helpers shared by the unit tests
+//
+
+namespace test_support
+{
+
+    // Single channel image of the given type whose elements, (7 y + 3 x)
+    // modulo 101, differ from their neighbours in both directions
+    //
+
+    inline cvip::matrix make_ramp(int const rows, int const cols, int const type = CV_8UC1)
+    {
+        auto im = cvip::matrix(rows, cols, CV_32SC1);
+
+        for (auto y = 0; y < rows; ++y)
+        {
+            for (auto x = 0; x < cols; ++x)
+            {
+                im.at<int>(y, x) = (7 * y + 3 * x) % 101;
+            }
+        }
+
+        if (type != CV_32SC1)
+        {
+            im.convertTo(im, type);
+        }
+
+        return im;
+    }
+
+}
+
+
+using test_support::make_ramp;
+
+
+#endif // !CVIP_TESTS_SUPPORT_HPP
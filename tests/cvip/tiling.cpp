@@ -0,0 +1,147 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <algorithm>
+
+
+using cvip::matrix;
+
+
+// A local predicate, the maximum over a square neighbourhood of the given
+// radius, borders are replicated. It is written pixel by pixel so that its
+// result depends on the actual extent of the image it receives.
+//
+
+struct dilate_predicate
+{
+    dilate_predicate(int radius) : m_radius{ radius }
+    {
+        // NOOP
+    }
+
+    void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+    {
+        dst.create(src.rows, src.cols, src.type());
+
+        for (auto y = 0; y < src.rows; ++y)
+        {
+            for (auto x = 0; x < src.cols; ++x)
+            {
+                auto value = 0;
+
+                for (auto v = y - m_radius; v <= y + m_radius; ++v)
+                {
+                    for (auto u = x - m_radius; u <= x + m_radius; ++u)
+                    {
+                        auto const r = std::clamp(v, 0, src.rows - 1);
+                        auto const c = std::clamp(u, 0, src.cols - 1);
+
+                        value = std::max(value, static_cast<int>(src.at<cvip::upix_t>(r, c)));
+                    }
+                }
+
+                dst.at<cvip::upix_t>(y, x) = static_cast<cvip::upix_t>(value);
+            }
+        }
+
+        src = matrix{ };
+    }
+
+    int halo() const
+    {
+        return m_radius;
+    }
+
+    int m_radius;
+};
+
+
+// A predicate that counts its calls, it does not declare a halo
+//
+
+struct counting_predicate
+{
+    void do_apply(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+    {
+        ++*m_calls;
+        src.copyTo(dst);
+        src = matrix{ };
+    }
+
+    int* m_calls;
+};
+
+
+struct tiling_operator_fake : public cvip::core::base_operator< tiling_operator_fake >
+{
+    virtual void apply(matrix& dst, matrix& src, bool const first) override
+    {
+        m_pr.do_apply(dst, src, first);
+    }
+
+    virtual cvip::core::operator_traits traits() const override
+    {
+        return { 1 };
+    }
+
+    dilate_predicate m_pr{ 1 };
+};
+
+
+// The unit tests
+//
+// Tiling::TiledResultMatchesWholeImageResult
+//
+// and
+//
+// Tiling::NonLocalOperatorFallsBackToWholeImage
+//
+// test that operator_expression::apply_tiled defined in
+// src/cvip/expression.cpp produces exactly the whole image result when the
+// tiles are grown by the halo of the chain, and that it is not used when an
+// operator in the chain is not local.
+//
+
+TEST(Tiling, TiledResultMatchesWholeImageResult)
+{
+    using dilate_operator = cvip::core::basic_operator<dilate_predicate>;
+
+    auto op1 = dilate_operator{ 1 };
+    auto op2 = dilate_operator{ 2 };
+    auto op3 = tiling_operator_fake{ };
+    auto x   = make_ramp(150, 200);
+
+    auto ex = op3 * op2 * op1;
+
+    auto y1 = ex * x;
+
+    ex.enable_tiling(2 * 40 * 40);
+
+    auto y2 = ex * x;
+
+    ASSERT_EQ(y1.size(), y2.size());
+    ASSERT_EQ(y1.type(), y2.type());
+    EXPECT_EQ(cv::norm(y1, y2), 0.0);
+}
+
+
+TEST(Tiling, NonLocalOperatorFallsBackToWholeImage)
+{
+    using counting_operator = cvip::core::basic_operator<counting_predicate>;
+
+    auto calls = 0;
+
+    auto op1 = counting_operator{ &calls };
+    auto op2 = tiling_operator_fake{ };
+    auto x   = make_ramp(150, 200);
+
+    auto ex = op2 * op1;
+
+    ex.enable_tiling(2 * 40 * 40);
+
+    auto y = ex * x;
+
+    EXPECT_EQ(calls, 1);
+}
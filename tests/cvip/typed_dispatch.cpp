@@ -0,0 +1,115 @@
+#include <gmock/gmock.h>
+#include <cvip/internal/basic_imports.hpp>
+#include <cvip/expression.hpp>
+#include <cvip/operator.hpp>
+#include "support.hpp"
+#include <stdexcept>
+#include <type_traits>
+
+
+using cvip::matrix;
+
+
+namespace
+{
+
+    // A predicate scaling each element by a factor, with typed kernels for
+    // 8 bits unsigned and single precision images only; it counts the calls
+    // of each kernel
+    //
+
+    struct scale_predicate
+    {
+        static inline auto byte_calls  = 0;
+        static inline auto float_calls = 0;
+
+        template<typename T>
+        std::enable_if_t<std::is_same_v<T, cvip::upix_t> or std::is_same_v<T, float>>
+        do_apply_as(matrix& dst, matrix& src, bool const first [[maybe_unused]])
+        {
+            ++(std::is_same_v<T, float> ? float_calls : byte_calls);
+
+            dst.create(src.rows, src.cols, src.type());
+
+            for (auto y = 0; y < src.rows; ++y)
+            {
+                for (auto x = 0; x < src.cols; ++x)
+                {
+                    dst.template at<T>(y, x) = static_cast<T>(src.template at<T>(y, x) * factor);
+                }
+            }
+
+            src = matrix{ };
+        }
+
+        int factor = 2;
+    };
+
+    using scale_operator = cvip::core::basic_operator<scale_predicate>;
+
+    using float_scale_operator = cvip::core::typed_operator<scale_predicate, float>;
+
+}
+
+
+// The unit test
+//
+// TypedDispatch::KernelIsPickedByDepth
+//
+// test that basic_operator::apply defined in internal/operator.inl calls
+// the typed kernel of the predicate for the depth of the image, in static
+// and dynamic expressions, and that it rejects the depths the predicate
+// has no kernel for.
+//
+
+TEST(TypedDispatch, KernelIsPickedByDepth)
+{
+    static_assert(cvip::core::is_operator_predicate<scale_predicate>::value);
+    static_assert(cvip::core::detail::typed_depths<scale_predicate> == ((1u << CV_8U) | (1u << CV_32F)));
+
+    auto const bytes  = matrix(4, 5, CV_8UC1, cv::Scalar::all(3));
+    auto const floats = matrix(4, 5, CV_32FC1, cv::Scalar::all(1.5));
+
+    scale_predicate::byte_calls  = 0;
+    scale_predicate::float_calls = 0;
+
+    auto const y1 = scale_operator{ } * bytes;
+    auto const y2 = cvip::core::make_static(scale_operator{ 3 }, scale_operator{ }) * floats;
+    auto const y3 = (scale_operator{ } * scale_operator{ }) * bytes;
+
+    EXPECT_EQ(scale_predicate::byte_calls, 3);
+    EXPECT_EQ(scale_predicate::float_calls, 2);
+    EXPECT_EQ(y1.at<cvip::upix_t>(3, 4), 6);
+    EXPECT_EQ(y2.at<float>(3, 4), 9.0f);
+    EXPECT_EQ(y3.at<cvip::upix_t>(3, 4), 12);
+
+    EXPECT_THROW(scale_operator{ } * matrix(4, 5, CV_16SC1), std::invalid_argument);
+}
+
+
+// The unit test
+//
+// TypedDispatch::TypedOperatorsAreBoundToTheirType
+//
+// test that a typed_operator defined in cvip/operator.hpp calls its kernel
+// with no dispatch, also when chained statically, and that it rejects an
+// image of another depth.
+//
+
+TEST(TypedDispatch, TypedOperatorsAreBoundToTheirType)
+{
+    static_assert(cvip::core::detail::typed_depths<cvip::core::typed_predicate<scale_predicate, float>> == 0u);
+
+    auto const floats = matrix(4, 5, CV_32FC1, cv::Scalar::all(1.5));
+
+    scale_predicate::float_calls = 0;
+
+    auto ex = cvip::core::make_static(float_scale_operator{ 3 }, float_scale_operator{ });
+
+    auto const y = ex * floats;
+
+    EXPECT_EQ(scale_predicate::float_calls, 2);
+    EXPECT_EQ(y.at<float>(0, 0), 9.0f);
+
+    EXPECT_THROW(float_scale_operator{ } * matrix(4, 5, CV_8UC1), std::invalid_argument);
+}